@@ -0,0 +1,368 @@
+#include <benchmark/benchmark.h>
+
+#include <random>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+#include <scm/scm.hpp>
+
+// Configs are generated in working directory before benchmarks run and removed after them
+namespace {
+    const auto MAIN_CFG  = std::string("scm_bench_main.cfg");
+    const auto DIRS_CFG  = std::string("scm_bench_dirs.cfg");
+    const auto DEEP_CFG  = std::string("scm_bench_deep.cfg");
+    const auto PROTO_CFG = std::string("scm_bench_protos.cfg");
+
+    constexpr int ENTITIES    = 4000;
+    constexpr int PROTOS      = 8;
+    constexpr int DEPTH       = 64;   // Length of inheritance chain in deep config
+    constexpr int DEEP_LEAVES = 8000;
+
+    const char* const KINDS[PROTOS] = {"orc", "elf", "human", "dwarf", "goblin", "troll", "wolf", "bear"};
+
+    auto readFile(const std::string& path) -> std::string {
+        auto stream = std::stringstream();
+        stream << std::ifstream(path).rdbuf();
+        return stream.str();
+    }
+
+    /**
+     * Game-like config: entities inherit prototypes, use interpolation, lists and comments
+     */
+    void writeMainConfig() {
+        auto dirs = std::ofstream(DIRS_CFG);
+        dirs << "; Directories\n[dirs]\ndata = /usr/share/game/\nmodels = $data models/\ntextures = $data textures/\n";
+
+        auto cfg = std::ofstream(MAIN_CFG);
+        cfg << "#include \"" << DIRS_CFG << "\"\n\n"
+            << "; Global settings\nversion = 3\ngravity = 9.81\nfullscreen = true\nlanguage = \"en\"\n\n";
+
+        for (auto kind : KINDS)
+            cfg << "[" << kind << "_proto]\n"
+                << "model = $dirs:models " << kind << "/body.mdl\n"
+                << "speed = 3.5     ; Tiles per second\n"
+                << "health = 100\n"
+                << "resistances = 0.1, 0.2, 0.3, 0.4\n\n";
+
+        for (int i = 0; i < ENTITIES; ++i)
+            cfg << "[entity_" << i << "] : " << KINDS[i % PROTOS] << "_proto\n"
+                << "name = \"" << KINDS[i % PROTOS] << " " << i << "\"\n"
+                << "health = " << 50 + i % 150 << "\n"
+                << "armor = " << i % 20 << "\n"
+                << "texture = $dirs:textures skin_" << i << ".dds\n"
+                << "hostile = " << (i % 3 ? "true" : "false") << "\n"
+                << "spawn = " << i % 1000 << ", " << i % 700 << "\n"
+                << "path = {{" << i << ", 1}, {2, 3}, {4, 5}, {6, 7}}\n\n";
+    }
+
+    /**
+     * Chain of DEPTH prototypes in separate file, and leaves which inherit all levels of it
+     * @param value - value of the root prototype, changed to make reload parse hierarchy again
+     */
+    void writeProtos(int value) {
+        auto cfg = std::ofstream(PROTO_CFG);
+        cfg << "[level_0]\nroot = " << value << "\n";
+
+        for (int i = 1; i < DEPTH; ++i)
+            cfg << "[level_" << i << "] : level_" << i - 1 << "\nvalue_" << i << " = " << i << "\n";
+    }
+
+    void writeDeepConfig() {
+        writeProtos(1);
+
+        auto cfg = std::ofstream(DEEP_CFG);
+        cfg << "#include \"" << PROTO_CFG << "\"\n";
+
+        for (int i = 0; i < DEEP_LEAVES; ++i)
+            cfg << "[leaf_" << i << "] : level_" << DEPTH - 1 - i % 8 << "\nid = " << i << "\n";
+    }
+
+    auto parsed(scm::parse_mode mode) -> scm::config& {
+        static scm::config text, typed;
+
+        auto& cfg = mode == scm::parse_mode::typed ? typed : text;
+        if (!cfg.is_section_exists("entity_0"))
+            cfg.parse(MAIN_CFG, mode);
+
+        return cfg;
+    }
+
+    /**
+     * Names of random entity sections, so reads aren't served from the same cache lines
+     */
+    auto entities() -> const std::vector<std::string>& {
+        static auto names = [] {
+            auto res  = std::vector<std::string>();
+            auto rand = std::mt19937(1);
+
+            for (int i = 0; i < 1024; ++i)
+                res.push_back("entity_" + std::to_string(rand() % ENTITIES));
+
+            return res;
+        }();
+
+        return names;
+    }
+
+    /**
+     * Random numbers of type T as text
+     */
+    template <typename T>
+    auto numbers() -> std::vector<std::string> {
+        auto res  = std::vector<std::string>();
+        auto rand = std::mt19937_64(1);
+
+        for (int i = 0; i < 1024; ++i) {
+            if constexpr (std::is_floating_point_v<T>) {
+                char buf[64];
+                auto mantissa = std::uniform_real_distribution<double>(-1000, 1000)(rand);
+                auto exponent = static_cast<int>(rand() % 20) - 10;
+
+                std::snprintf(buf, sizeof(buf), "%.*ge%d", std::numeric_limits<T>::digits10, mantissa, exponent);
+                res.emplace_back(buf);
+            } else {
+                res.push_back(std::to_string(static_cast<T>(rand()) + T(0)));
+            }
+        }
+
+        return res;
+    }
+}
+
+
+////////////////////////////////// Parsing ///////////////////////////////////
+
+static void BM_Tokenize(benchmark::State& state) {
+    auto text = readFile(MAIN_CFG);
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(scm_details::tokenize(MAIN_CFG, text));
+
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * text.size()));
+}
+BENCHMARK(BM_Tokenize)->Unit(benchmark::kMillisecond);
+
+static void BM_ProcessFileTask(benchmark::State& state) {
+    auto size = readFile(MAIN_CFG).size() + readFile(DIRS_CFG).size();
+    auto pool = scm_details::TaskPool();
+    auto data = scm_details::CfgData();
+
+    for (auto _ : state) {
+        scm_details::processFileTask(data, pool, MAIN_CFG);
+
+        state.PauseTiming();
+        data.clear();
+        state.ResumeTiming();
+    }
+
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * size));
+}
+BENCHMARK(BM_ProcessFileTask)->Unit(benchmark::kMillisecond);
+
+// Whole parse: files, references, inheritance and preparse in typed mode
+static void BM_Parse(benchmark::State& state) {
+    auto size = readFile(MAIN_CFG).size() + readFile(DIRS_CFG).size();
+    auto mode = static_cast<scm::parse_mode>(state.range(0));
+
+    for (auto _ : state) {
+        auto cfg = scm::config();
+        cfg.parse(MAIN_CFG, mode);
+    }
+
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * size));
+}
+BENCHMARK(BM_Parse)->Arg(int(scm::parse_mode::text))->Arg(int(scm::parse_mode::typed))->Unit(benchmark::kMillisecond);
+
+static void BM_ParseDeepHierarchy(benchmark::State& state) {
+    for (auto _ : state) {
+        auto cfg = scm::config();
+        cfg.parse(DEEP_CFG);
+    }
+}
+BENCHMARK(BM_ParseDeepHierarchy)->Unit(benchmark::kMillisecond);
+
+// Root prototype changes, so all levels and leaves which inherit them are parsed again
+static void BM_ReloadParents(benchmark::State& state) {
+    auto cfg   = scm::config();
+    auto value = 1;
+
+    cfg.parse(DEEP_CFG);
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        value = value == 1 ? 22 : 1; // Size changes, so file is reloaded even within one mtime tick
+        writeProtos(value);
+        state.ResumeTiming();
+
+        cfg.reload(DEEP_CFG);
+    }
+
+    writeProtos(1);
+}
+BENCHMARK(BM_ReloadParents)->Unit(benchmark::kMillisecond);
+
+
+/////////////////////////////// Conversions //////////////////////////////////
+
+// Values are unpacked as stored by parser, without spaces between elements
+static void BM_UnpackNested(benchmark::State& state) {
+    auto value = std::string_view("{{1,2},{3,4},{5,6},{7,8}},{\"a\",\"b\"},9");
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(scm_details::unpack("value", "section", value, 0));
+}
+BENCHMARK(BM_UnpackNested);
+
+static void BM_UnpackList(benchmark::State& state) {
+    auto value = std::string();
+    for (int i = 0; i < 64; ++i)
+        value += (i ? "," : "") + std::to_string(i * 37);
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(scm_details::unpack("value", "section", value, 0));
+
+    state.SetItemsProcessed(state.iterations() * 64);
+}
+BENCHMARK(BM_UnpackList);
+
+template <typename T>
+static void BM_Aton(benchmark::State& state) {
+    auto strs = numbers<T>();
+    auto i    = size_t(0);
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(scm::aton<T>(strs[i++ & 1023], "value", "section"));
+
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK_TEMPLATE(BM_Aton, int8_t);
+BENCHMARK_TEMPLATE(BM_Aton, uint8_t);
+BENCHMARK_TEMPLATE(BM_Aton, int16_t);
+BENCHMARK_TEMPLATE(BM_Aton, uint16_t);
+BENCHMARK_TEMPLATE(BM_Aton, int32_t);
+BENCHMARK_TEMPLATE(BM_Aton, uint32_t);
+BENCHMARK_TEMPLATE(BM_Aton, int64_t);
+BENCHMARK_TEMPLATE(BM_Aton, uint64_t);
+BENCHMARK_TEMPLATE(BM_Aton, float);
+BENCHMARK_TEMPLATE(BM_Aton, double);
+
+
+/////////////////////////////////// Reads ////////////////////////////////////
+
+static void BM_ReadOwn(benchmark::State& state) {
+    auto& cfg  = parsed(static_cast<scm::parse_mode>(state.range(0)));
+    auto& sect = entities();
+    auto  i    = size_t(0);
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(cfg.read<int>("health", sect[i++ & 1023]));
+}
+BENCHMARK(BM_ReadOwn)->Arg(int(scm::parse_mode::text))->Arg(int(scm::parse_mode::typed));
+
+static void BM_ReadInherited(benchmark::State& state) {
+    auto& cfg  = parsed(scm::parse_mode::text);
+    auto& sect = entities();
+    auto  i    = size_t(0);
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(cfg.read<float>("speed", sect[i++ & 1023]));
+}
+BENCHMARK(BM_ReadInherited);
+
+static void BM_ReadFrozen(benchmark::State& state) {
+    auto  cfg  = scm::config();
+    auto& sect = entities();
+    auto  i    = size_t(0);
+
+    cfg.parse(MAIN_CFG, scm::parse_mode::typed);
+    cfg.freeze();
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(cfg.read<int>("health", sect[i++ & 1023]));
+}
+BENCHMARK(BM_ReadFrozen);
+
+static void BM_ReadHandle(benchmark::State& state) {
+    auto& cfg    = parsed(scm::parse_mode::typed);
+    auto  handle = scm::key_handle("health", "entity_123");
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(cfg.read<int>(handle));
+}
+BENCHMARK(BM_ReadHandle);
+
+static void BM_ReadString(benchmark::State& state) {
+    auto& cfg  = parsed(scm::parse_mode::text);
+    auto& sect = entities();
+    auto  i    = size_t(0);
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(cfg.read<std::string>("name", sect[i++ & 1023]));
+}
+BENCHMARK(BM_ReadString);
+
+static void BM_ReadNested(benchmark::State& state) {
+    auto& cfg  = parsed(scm::parse_mode::text);
+    auto& sect = entities();
+    auto  i    = size_t(0);
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(cfg.read<std::vector<std::pair<int, int>>>("path", sect[i++ & 1023]));
+}
+BENCHMARK(BM_ReadNested);
+
+// read<T> reports missing key with exception
+static void BM_ReadMiss(benchmark::State& state) {
+    auto& cfg = parsed(scm::parse_mode::text);
+
+    for (auto _ : state) {
+        try {
+            benchmark::DoNotOptimize(cfg.read<int>("missing", "entity_123"));
+        }
+        catch (const scm::CfgException&) {}
+    }
+}
+BENCHMARK(BM_ReadMiss);
+
+static void BM_ReadIe(benchmark::State& state) {
+    auto& cfg  = parsed(scm::parse_mode::text);
+    auto  key  = state.range(0) == 0 ? "health" : "missing";
+    auto  sect = state.range(0) == 2 ? "missing" : "entity_123";
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(cfg.read_ie<int>(key, sect, -1));
+
+    state.SetLabel(state.range(0) == 0 ? "hit" : state.range(0) == 1 ? "missing key" : "missing section");
+}
+BENCHMARK(BM_ReadIe)->DenseRange(0, 2);
+
+static void BM_ReadIke(benchmark::State& state) {
+    auto& cfg = parsed(scm::parse_mode::text);
+    auto  key = state.range(0) == 0 ? "health" : "missing";
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(cfg.read_ike<int>(key, "entity_123", -1));
+
+    state.SetLabel(state.range(0) == 0 ? "hit" : "missing key");
+}
+BENCHMARK(BM_ReadIke)->DenseRange(0, 1);
+
+
+int main(int argc, char** argv) {
+    benchmark::Initialize(&argc, argv);
+
+    if (benchmark::ReportUnrecognizedArguments(argc, argv))
+        return 1;
+
+    writeMainConfig();
+    writeDeepConfig();
+
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+
+    for (auto& file : {MAIN_CFG, DIRS_CFG, DEEP_CFG, PROTO_CFG})
+        std::remove(file.data());
+
+    return 0;
+}
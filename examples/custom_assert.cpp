@@ -1,5 +1,6 @@
 #include <string>
 #include <iostream>
+#include <cstdlib>
 
 // Don't use format and no variable arguments in this function to simplify example :)
 void custom_assert(bool condition, const char* file, int line, const std::string& format, const std::string& what) {
@@ -7,6 +8,7 @@ void custom_assert(bool condition, const char* file, int line, const std::string
         std::cerr << "[Fatal error]: " << std::endl;
         std::cerr << "What: " << what << std::endl;
         std::cerr << "Source: " << file << ":" << line << std::endl;
+        std::exit(EXIT_FAILURE);
     }
 }
 
@@ -1,7 +1,7 @@
 #include <map>
 #include <string>
 
-// Use std::map as ScmMap (instead std::unordered_map)
+// Use std::map as ScmMap (instead scm_details::FlatMap)
 #define SCM_TYPE_MAP std::map
 
 
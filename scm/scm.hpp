@@ -3,6 +3,10 @@
 #include "scm_details.hpp"
 #include "scm_aton.hpp"
 
+#ifndef SCM_NO_THREADS
+    #include "scm_watcher.hpp"
+#endif
+
 #define IA inline auto
 #define IS_WHITE_SPACE(CH) ((CH) == ' ' || (CH) == '\t')
 
@@ -11,38 +15,926 @@
 #endif
 
 namespace SCM_NAMESPACE {
+    enum class parse_mode {
+        text,  // Values are stored as strings and converted on every read
+        typed  // Numbers and bools are also converted at load time, reads of them skip conversion
+    };
+
+    /**
+     * Pre-resolved section + key pair
+     * Pointer to value is cached on first access and resolved again only after parse, reload or clear.
+     * Hashes are computed at compile time for literals, lookups in frozen config (see config::freeze)
+     * use them instead of hashing the names again
+     */
+    class key_handle {
+    public:
+        constexpr explicit key_handle(std::string_view key, std::string_view section = scm_details::GLOBAL_NAMESPACE):
+            _key(key), _section(section), _keyHash(fnv1a(key)), _hash(hash_combine(fnv1a(section), _keyHash)) {}
+
+        constexpr auto key() const -> std::string_view {
+            return _key;
+        }
+
+        constexpr auto section() const -> std::string_view {
+            return _section;
+        }
+
+        constexpr auto hash() const -> std::uint64_t {
+            return _hash;
+        }
+
+        constexpr key_handle(const key_handle& other):
+            _key(other._key), _section(other._section), _keyHash(other._keyHash), _hash(other._hash) {}
+
+        key_handle& operator= (const key_handle&) = delete;
+
+        /**
+         * Get value of the key in the default config
+         * @return pointer to value or nullptr if key or section doesn't exists.
+         * Pointer is valid while snapshot exists or until config is replaced
+         */
+        auto resolve() const -> const scm_details::Value*;
+
+        /**
+         * Get value of the key in data
+         * Handle may be shared by threads which read different data, so cache is written as seqlock.
+         * Readers never wait: cache is skipped while other thread writes it
+         * @return pointer to value or nullptr if key or section doesn't exists
+         */
+        auto resolve(const scm_details::CfgData& data) const -> const scm_details::Value* {
+            auto version = _version.load(std::memory_order_acquire);
+
+            if (!(version & 1) && _generation.load(std::memory_order_relaxed) == data.generation()) {
+                auto value = _value.load(std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_acquire);
+
+                if (_version.load(std::memory_order_relaxed) == version)
+                    return value;
+            }
+
+            auto value = data.findValue(_section, _key, _keyHash, _hash);
+
+            if (!(version & 1) && _version.compare_exchange_strong(version, version + 1, std::memory_order_relaxed)) {
+                std::atomic_thread_fence(std::memory_order_release);
+                _value.store(value, std::memory_order_relaxed);
+                _generation.store(data.generation(), std::memory_order_relaxed);
+                _version.store(version + 2, std::memory_order_release);
+            }
+
+            return value;
+        }
+
+        /**
+         * Get value of the key in data
+         * @return value. Throws if key or section doesn't exists
+         */
+        auto value(const scm_details::CfgData& data) const -> const scm_details::Value& {
+            auto str = resolve(data);
+            return str ? *str : data.getValue(_section, _key);
+        }
+
+        constexpr bool operator==(const key_handle& rhs) const {
+            return _hash == rhs._hash && _key == rhs._key && _section == rhs._section;
+        }
+
+        constexpr bool operator!=(const key_handle& rhs) const {
+            return !(*this == rhs);
+        }
+
+    private:
+        std::string_view _key;
+        std::string_view _section;
+        std::uint64_t    _keyHash;
+        std::uint64_t    _hash;
+
+        mutable std::atomic<const scm_details::Value*> _value      = nullptr;
+        mutable std::atomic<ScmSizeT>                  _generation = 0;
+        mutable std::atomic<ScmSizeT>                  _version    = 0; // Odd while cache is written
+    };
+
+    /**
+     * Config instance. Free functions of SCM_NAMESPACE use the default instance (see default_config).
+     * Independent instances can be parsed, reloaded and read in parallel.
+     * All member functions may be called from any thread, reads never wait.
+     * Changes of one instance (parse, reload, materialize, ..., and the watcher) are applied one at a time
+     */
+    class config {
+    public:
+        config() = default;
+
+        config(const config&) = delete;
+        config& operator= (const config&) = delete;
+
+        /**
+         * Parse config file and all includes
+         * New data is prepared aside and replaces current data only if parse succeeds, concurrent reads aren't blocked
+         * If config is empty and up to date compiled cache exists (see save_cache), it is loaded instead
+         * Throws if config is frozen
+         * @param filepath - path to file
+         * @param mode - parse mode
+         */
+        void parse(const ScmStrView& filepath, parse_mode mode = parse_mode::text) {
+            using namespace scm_details;
+
+            auto lock = WriteGuard(_slot);
+            auto next = std::unique_ptr<CfgData>();
+            {
+                auto  pin  = Epochs::Pin();
+                auto& data = _slot.get();
+
+                SCM_EXCEPTION(CfgException, !data.frozen(), "Can't parse '", filepath, "'. Config is frozen");
+
+                next = data.empty() ? data.cloneEmpty() : data.clone();
+            }
+
+            scm_details::parse(*next, filepath, mode == parse_mode::typed);
+            _slot.publish(std::move(next));
+        }
+
+        /**
+         * Save parsed data to compiled cache '<filepath>.scmc'
+         * Next parse of filepath into empty config loads the cache instead of parsing text,
+         * while filepath and all included files keep their size and modification time
+         * @param filepath - path to config file, data must be parsed from this file only
+         */
+        void save_cache(const ScmStrView& filepath) const {
+            auto guard = scm_details::ReadGuard(_slot);
+            scm_details::saveCache(guard.data(), filepath);
+        }
+
+        /**
+         * Clear config data. Frozen config is thawed
+         */
+        void clear() {
+            auto lock = scm_details::WriteGuard(_slot);
+            _slot.publish(std::make_unique<scm_details::CfgData>());
+        }
+
+        /**
+         * Parse config file again
+         * If config was parsed only from filepath, parses only changed files and sections which
+         * depend on them through interpolation or inheritance. Otherwise parses config file from scratch
+         * Like parse, replaces current data only on success. Throws if config is frozen
+         */
+        void reload(const ScmStrView& filepath, parse_mode mode = parse_mode::text) {
+            using namespace scm_details;
+
+            auto lock     = WriteGuard(_slot);
+            auto preparse = mode == parse_mode::typed;
+            auto next     = std::unique_ptr<CfgData>();
+            {
+                auto  pin   = Epochs::Pin();
+                auto& data  = _slot.get();
+                auto& roots = data.roots();
+
+                SCM_EXCEPTION(CfgException, !data.frozen(), "Can't reload '", filepath, "'. Config is frozen");
+
+                if (roots.size() == 1 && roots.front() == filepath) {
+                    if (!sourcesChanged(data) && (!preparse || data.preparsed()))
+                        return;
+
+                    next = data.clone();
+                }
+            }
+
+            if (!next || !reloadChanged(*next, preparse)) {
+                auto pin = Epochs::Pin();
+                next = _slot.get().cloneEmpty();
+                scm_details::parse(*next, filepath, preparse, false);
+            }
+
+            _slot.publish(std::move(next));
+        }
+
+        /**
+         * Store inherited values in the section itself. Sections keep only their own values by default,
+         * and reads of inherited keys look them up in parents. Useful for sections which are read often
+         * and have long parent chains. Section stays materialized after parse and reload, until clear
+         * Throws if config is frozen
+         * @param section - section name, may be not parsed yet
+         */
+        void materialize(const ScmStrView& section) {
+            using namespace scm_details;
+
+            auto lock = WriteGuard(_slot);
+            auto next = std::unique_ptr<CfgData>();
+            {
+                auto  pin  = Epochs::Pin();
+                auto& data = _slot.get();
+
+                SCM_EXCEPTION(CfgException, !data.frozen(), "Can't materialize [", section, "]. Config is frozen");
+
+                next = data.clone();
+            }
+
+            next->materialize(section);
+            _slot.publish(std::move(next));
+        }
+
+        /**
+         * Make config read-only. Values of all sections are indexed by minimal perfect hash of (section, key),
+         * lookup reads one bucket seed and one slot with the value instead of following map buckets.
+         * parse, reload and materialize throw until thaw or clear. Can't be used while config is watched.
+         * Throws if the index can't be built (hashes of two values collide), config stays unfrozen then
+         */
+        void freeze() {
+            using namespace scm_details;
+
+            auto lock = WriteGuard(_slot);
+#ifndef SCM_NO_THREADS
+            SCM_EXCEPTION(CfgException, !_watcher, "Can't freeze watched config");
+#endif
+            auto next = std::unique_ptr<CfgData>();
+            {
+                auto pin = Epochs::Pin();
+                if (_slot.get().frozen())
+                    return;
+
+                next = _slot.get().clone();
+            }
+
+            next->freeze();
+            _slot.publish(std::move(next));
+        }
+
+        /**
+         * Allow changes of frozen config again
+         */
+        void thaw() {
+            using namespace scm_details;
+
+            auto lock = WriteGuard(_slot);
+            auto next = std::unique_ptr<CfgData>();
+            {
+                auto pin = Epochs::Pin();
+                if (!_slot.get().frozen())
+                    return;
+
+                next = _slot.get().clone();
+            }
+
+            next->thaw();
+            _slot.publish(std::move(next));
+        }
+
+        /**
+         * @return true if config is frozen (see freeze)
+         */
+        bool is_frozen() const {
+            auto guard = scm_details::ReadGuard(_slot);
+            return guard.data().frozen();
+        }
+
+#ifndef SCM_NO_THREADS
+        /**
+         * Watch config file and all its includes. When they change, config is parsed in background thread
+         * and replaces current data atomically: reads never wait and never see partially parsed config.
+         * Use snapshot to keep references returned by reads valid
+         * @param filepath - path to file, current data must be parsed from it
+         * @param mode - parse mode
+         * @param callback - called from watcher thread after every parse with nullptr on success
+         * or with exception thrown by parser, current data is kept in that case.
+         * Callback may call watch and unwatch or destroy the config
+         */
+        void watch(const ScmStrView& filepath, parse_mode mode = parse_mode::text,
+                   std::function<void(std::exception_ptr)> callback = {}) {
+            auto previous = std::unique_ptr<scm_details::Watcher>();
+            {
+                auto  lock  = scm_details::WriteGuard(_slot);
+                auto  guard = scm_details::ReadGuard(_slot);
+                auto& roots = guard.data().roots();
+
+                SCM_EXCEPTION(CfgException, !guard.data().frozen(), "Can't watch '", filepath, "'. Config is frozen");
+                SCM_EXCEPTION(CfgException, roots.size() == 1 && roots.front() == filepath,
+                              "Can't watch '", filepath, "'. Data must be parsed from this file only");
+
+                previous = std::move(_watcher);
+                _watcher = std::make_unique<scm_details::Watcher>(_slot, filepath, mode == parse_mode::typed,
+                                                                  std::move(callback));
+            }
+
+            // Previous watcher may wait for the lock to publish data, so it's stopped without it
+            previous.reset();
+        }
+
+        /**
+         * Stop watching and free replaced data which isn't read anymore
+         */
+        void unwatch() {
+            auto previous = std::unique_ptr<scm_details::Watcher>();
+            {
+                auto lock = scm_details::WriteGuard(_slot);
+                previous  = std::move(_watcher);
+            }
+
+            previous.reset();
+            scm_details::Epochs::instance().reclaim();
+        }
+#endif
+
+        /**
+         * Check is section exists
+         * @param section - section for checking
+         * @return true if exists otherwise false
+         */
+        bool is_section_exists(const ScmStrView& section) const {
+            auto guard = scm_details::ReadGuard(_slot);
+            return guard.data().isSectionExists(section);
+        }
+
+        /**
+         * Check is key exists on section
+         * @param key - key string
+         * @param section - section string
+         * @return true if key exists in section, false if not or section doesn't exist too
+         */
+        bool is_key_exists(const ScmStrView& key, const ScmStrView& section = scm_details::GLOBAL_NAMESPACE) const {
+            auto guard = scm_details::ReadGuard(_slot);
+            return guard.data().isValueExists(section, key);
+        }
+
+        /**
+         * Check is key exists
+         * @param handle - key handle
+         * @return true if key exists in section, false if not or section doesn't exist too
+         */
+        bool is_key_exists(const key_handle& handle) const {
+            auto guard = scm_details::ReadGuard(_slot);
+            return handle.resolve(guard.data()) != nullptr;
+        }
+
+        /**
+         * Read one value from cfg
+         * @tparam T - value type
+         * @param key - value key
+         * @param section - section name. If unused - perform read from global namespace
+         * @return Value with T type
+         */
+        template <typename T>
+        auto read(const ScmStrView& key, const ScmStrView& section = scm_details::GLOBAL_NAMESPACE) const {
+            using namespace scm_details;
+
+            auto guard = ReadGuard(_slot);
+            return readValue<T>(guard.data().getValue(section, key), key, section);
+        }
+
+        /**
+         * Read one value from cfg by key handle
+         * @tparam T - value type
+         * @param handle - key handle
+         * @return Value with T type
+         */
+        template <typename T>
+        auto read(const key_handle& handle) const {
+            using namespace scm_details;
+
+            auto guard = ReadGuard(_slot);
+            return readValue<T>(handle.value(guard.data()), handle.key(), handle.section());
+        }
+
+        /**
+         * Read two ore more values from cfg by key handle
+         * @tparam T1 - type of first value
+         * @tparam T2 - type of second value
+         * @tparam Ts - type of other values
+         * @param handle - key handle
+         * @return Tuple of read values
+         */
+        template <typename T1, typename T2, typename... Ts>
+        auto read(const key_handle& handle) const {
+            using namespace scm_details;
+
+            auto guard = ReadGuard(_slot);
+            auto vec   = unpack(handle.key(), handle.section(), handle.value(guard.data()), sizeof...(Ts) + 2);
+            auto is    = std::make_index_sequence<sizeof...(Ts) + 2>();
+
+            return readTupleImpl<T1, T2, Ts...>(vec, handle.key(), handle.section(), is);
+        }
+
+        /**
+         * Read one value from cfg by key handle if key or section exists
+         * @tparam T - value type
+         * @param handle - key handle
+         * @param default_val - default value
+         * @return Value with T type or default_val if key or section doesn't exists
+         */
+        template <typename T>
+        auto read_ie(const key_handle& handle, const T& default_val) const {
+            using namespace scm_details;
+
+            auto guard = ReadGuard(_slot);
+            auto str   = handle.resolve(guard.data());
+
+            if (str)
+                return readValue<T>(*str, handle.key(), handle.section());
+            else
+                return default_val;
+        }
+
+        /**
+         * Read two ore more values from cfg
+         * @tparam T1 - type of first value
+         * @tparam T2 - type of second value
+         * @tparam Ts - type of other values
+         * @param key - value key
+         * @param section - section name. If unused - perform read from global namespace
+         * @return Tuple of read values
+         */
+        template <typename T1, typename T2, typename... Ts>
+        auto read(const ScmStrView& key, const ScmStrView& section = scm_details::GLOBAL_NAMESPACE) const {
+            using namespace scm_details;
+
+            auto guard = ReadGuard(_slot);
+            auto str   = guard.data().getValue(section, key);
+            auto vec   = unpack(key, section, str, sizeof...(Ts) + 2);
+            auto is    = std::make_index_sequence<sizeof...(Ts) + 2>();
+
+            return readTupleImpl<T1, T2, Ts...>(vec, key, section, is);
+        }
+
+        /**
+         * Read one value from cfg and cache converted result
+         * Next reads of the same key with the same type return the stored value without conversion
+         * Cache is dropped on parse, reload and clear
+         * @tparam T - value type
+         * @param key - value key
+         * @param section - section name. If unused - perform read from global namespace
+         * @return Reference to value with T type, valid while snapshot exists or until config is replaced
+         */
+        template <typename T>
+        auto read_cached(const ScmStrView& key, const ScmStrView& section = scm_details::GLOBAL_NAMESPACE) const
+        -> const T& {
+            using namespace scm_details;
+
+            auto  guard = ReadGuard(_slot);
+            auto& data  = guard.data();
+            auto& str   = data.getValue(section, key);
+
+            return data.cache().get<T>(&str, [&] { return readValue<T>(str, key, section); });
+        }
+
+        /**
+         * Read one value from cfg by key handle and cache converted result
+         * @tparam T - value type
+         * @param handle - key handle
+         * @return Reference to value with T type, valid while snapshot exists or until config is replaced
+         */
+        template <typename T>
+        auto read_cached(const key_handle& handle) const -> const T& {
+            using namespace scm_details;
+
+            auto  guard = ReadGuard(_slot);
+            auto& data  = guard.data();
+            auto  str   = handle.resolve(data);
+
+            if (!str)
+                str = &data.getValue(handle.section(), handle.key());
+
+            return data.cache().get<T>(str, [&] { return readValue<T>(*str, handle.key(), handle.section()); });
+        }
+
+        /**
+         * Read list of values directly into memory without intermediate containers
+         * @tparam T - element type
+         * @param data - output buffer
+         * @param size - buffer size. Exception if list contains more values
+         * @param key - value key
+         * @param section - section name. If unused - perform read from global namespace
+         * @return Number of read values
+         */
+        template <typename T>
+        auto read_into(T* data, ScmSizeT size, const ScmStrView& key,
+                       const ScmStrView& section = scm_details::GLOBAL_NAMESPACE) const -> ScmSizeT {
+            using namespace scm_details;
+
+            auto  guard = ReadGuard(_slot);
+            SizeT i     = 0;
+
+            return unpackEach(key, section, guard.data().getValue(section, key), 0, [&](StrViewCref elem) {
+                SCM_EXCEPTION(CfgException, i < size, "Too many values at key '", key, "' in section [", section,
+                              "]. Buffer size is ", std::to_string(size).data(), ".");
+
+                data[i++] = superCast<T>(elem, key, section);
+            });
+        }
+
+        /**
+         * Read list of values into output iterator without intermediate containers
+         * @tparam T - element type
+         * @param out - output iterator
+         * @param key - value key
+         * @param section - section name. If unused - perform read from global namespace
+         * @return Output iterator past the last written value
+         */
+        template <typename T, typename OutIt>
+        auto read_into(OutIt out, const ScmStrView& key, const ScmStrView& section = scm_details::GLOBAL_NAMESPACE) const {
+            using namespace scm_details;
+
+            auto guard = ReadGuard(_slot);
+
+            unpackEach(key, section, guard.data().getValue(section, key), 0, [&](StrViewCref elem) {
+                *out++ = superCast<T>(elem, key, section);
+            });
+
+            return out;
+        }
+
+        /**
+         * Read one value from cfg if key or section exists
+         * @tparam T - value type
+         * @param key - value key
+         * @param section - section name
+         * @param default_val - default value
+         * @return Value with T type or default_val if key or section doesn't exists
+         */
+        template <typename T>
+        auto read_ie(const ScmStrView& key, const ScmStrView& section, const T& default_val) const {
+            using namespace scm_details;
+
+            auto guard = ReadGuard(_slot);
+            auto str   = guard.data().findValue(section, key);
+
+            if (str)
+                return readValue<T>(*str, key, section);
+            else
+                return default_val;
+        }
+
+        /**
+         * Read two ore more values from cfg if key or section exists
+         * @tparam T1 - type of first value
+         * @tparam T2 - type of second value
+         * @tparam Ts - type of other values
+         * @param key - value key
+         * @param section - section name
+         * @param def_val1 - first default value
+         * @param def_val2 - second default value
+         * @param default_vals - other default values
+         * @return Tuple of read values or default_vals if key or section doesn't exists
+         */
+        template <typename T1, typename T2, typename... Ts>
+        auto read_ie(const ScmStrView& key, const ScmStrView& section,
+                     const T1& def_val1, const T2& def_val2, const Ts& ... default_vals) const
+        {
+            using namespace scm_details;
+
+            auto guard = ReadGuard(_slot);
+            auto str   = guard.data().findValue(section, key);
+
+            if (str) {
+                auto vec = unpack(key, section, *str, sizeof...(Ts) + 2);
+                auto is = std::make_index_sequence<sizeof...(Ts) + 2>();
+
+                return readTupleImpl<T1, T2, Ts...>(vec, key, section, is);
+            }
+            else {
+                return std::make_tuple(def_val1, def_val2, default_vals...);
+            }
+        }
+
+        /**
+         * Read one value from cfg from global namespace if key or section exists
+         * @tparam T - value type
+         * @tparam Ts - other values types
+         * @param key - value key
+         * @param default_val - default value
+         * @param default_vals - other default values
+         * @return Value with T type (tuple with <T, Ts...>) or default_val (tuple of default_vals) if key or section doesn't exists
+         */
+        template <typename T, typename... Ts>
+        auto read_ie(const ScmStrView& key, const T& default_val, const Ts& ... default_vals,
+                     std::enable_if_t<scm_details::no_str_view_or_c_array<T>>* = 0) const
+        {
+            using namespace scm_details;
+
+            return read_ie<T, Ts...>(key, GLOBAL_NAMESPACE, default_val, default_vals...);
+        }
+
+        /**
+         * Read one value from cfg if key exists
+         * @tparam T - value type
+         * @param key - value key
+         * @param section - section name
+         * @param default_val - default value
+         * @return Value with T type or default_val if key doesn't exists
+         */
+        template <typename T>
+        auto read_ike(const ScmStrView& key, const ScmStrView& section, const T& default_val) const {
+            using namespace scm_details;
+
+            auto  guard = ReadGuard(_slot);
+            auto& data  = guard.data();
+            auto  str   = data.findValue(data.getSection(section), key);
+
+            if (str)
+                return readValue<T>(*str, key, section);
+            else
+                return default_val;
+        }
+
+        /**
+         * Read two ore more values from cfg if key exists
+         * @tparam T1 - type of first value
+         * @tparam T2 - type of second value
+         * @tparam Ts - type of other values
+         * @param key - value key
+         * @param section - section name
+         * @param def_val1 - first default value
+         * @param def_val2 - second default value
+         * @param default_vals - other default values
+         * @return Tuple of read values or default_vals if key doesn't exists
+         */
+        template <typename T1, typename T2, typename... Ts>
+        auto read_ike(const ScmStrView& key, const ScmStrView& section,
+                      const T1& def_val1, const T2& def_val2, const Ts& ... default_vals) const
+        {
+            using namespace scm_details;
+
+            auto  guard = ReadGuard(_slot);
+            auto& data  = guard.data();
+            auto  str   = data.findValue(data.getSection(section), key);
+
+            if (str) {
+                auto vec = unpack(key, section, *str, sizeof...(Ts) + 2);
+                auto is = std::make_index_sequence<sizeof...(Ts) + 2>();
+
+                return readTupleImpl<T1, T2, Ts...>(vec, key, section, is);
+            }
+            else {
+                return std::make_tuple(def_val1, def_val2, default_vals...);
+            }
+        }
+
+        /**
+         * Read one value from cfg from global namespace if key exists
+         * @tparam T - value type
+         * @tparam Ts - other values types
+         * @param key - value key
+         * @param default_val - default value
+         * @param default_vals - other default values
+         * @return Value with T type (tuple with <T, Ts...>) or default_val (tuple of default_vals) if key doesn't exists
+         */
+        template <typename T, typename... Ts>
+        auto read_ike(const ScmStrView& key, const T& default_val, const Ts& ... default_vals,
+                      std::enable_if_t<scm_details::no_str_view_or_c_array<T>>* = 0) const
+        {
+            using namespace scm_details;
+
+            return read_ike<T, Ts...>(key, GLOBAL_NAMESPACE, default_val, default_vals...);
+        }
+
+        /**
+         * Set value from config
+         * @tparam T - value type
+         * @param val - value to be set
+         * @param key - key string
+         * @param section - section string (optional)
+         */
+        template <typename T>
+        void set(T& val, const ScmStrView& key, const ScmStrView& section = scm_details::GLOBAL_NAMESPACE) const {
+            val = read<T>(key, section);
+        }
+
+        /**
+         * Set value from config by key handle
+         * @tparam T - value type
+         * @param val - value to be set
+         * @param handle - key handle
+         */
+        template <typename T>
+        void set(T& val, const key_handle& handle) const {
+            val = read<T>(handle);
+        }
+
+        /**
+         * Set value from config by key handle if section or key exists. Otherwise set default_value
+         * @tparam T - value type
+         * @tparam D - default value type
+         * @param val - value to be set
+         * @param handle - key handle
+         * @param default_value - default value
+         */
+        template <typename T, typename D>
+        void set_ie(T& val, const key_handle& handle, const D& default_value) const {
+            val = read_ie<T>(handle, T(default_value));
+        }
+
+        /**
+         * Set value from config if section or key exists. Otherwise set default_value
+         * @tparam T - value type
+         * @tparam D - default value type
+         * @param val - value to be set
+         * @param key - key string
+         * @param section - section string
+         * @param default_value - default value
+         */
+        template <typename T, typename D>
+        void set_ie(T& val, const ScmStrView& key, const ScmStrView& section, const D& default_value) const {
+            val = read_ie<T>(key, section, T(default_value));
+        }
+
+        /**
+         * Set value from config global section if section or key exists. Otherwise set default_value
+         * @tparam T - value type
+         * @tparam D - default value type
+         * @param val - value to be set
+         * @param key - key string
+         * @param default_value - default value
+         */
+        template <typename T, typename D>
+        void set_ie(T& val, const ScmStrView& key, const D& default_value) const {
+            using namespace scm_details;
+
+            set_ie<T>(val, key, GLOBAL_NAMESPACE, T(default_value));
+        }
+
+        /**
+         * Set value from config if key exists. Otherwise set default_value
+         * @tparam T - value type
+         * @tparam D - default value type
+         * @param val - value to be set
+         * @param key - key string
+         * @param section - section string
+         * @param default_value - default value
+         */
+        template <typename T, typename D>
+        void set_ike(T& val, const ScmStrView& key, const ScmStrView& section, const D& default_value) const {
+            val = read_ike<T>(key, section, T(default_value));
+        }
+
+        /**
+         * Set value from config global section if key exists. Otherwise set default_value
+         * @tparam T - value type
+         * @tparam D - default value type
+         * @param val - value to be set
+         * @param key - key string
+         * @param default_value - default value
+         */
+        template <typename T, typename D>
+        void set_ike(T& val, const ScmStrView& key, const D& default_value) const {
+            using namespace scm_details;
+
+            set_ike<T>(val, key, GLOBAL_NAMESPACE, T(default_value));
+        }
+
+        /**
+         * Fill object members declared with SCM_BIND from section
+         * All members are read with a single section lookup, errors are reported at once
+         * @tparam T - object type
+         * @param obj - object to be filled
+         * @param section - section string
+         */
+        template <typename T>
+        void bind(T& obj, const ScmStrView& section) const {
+            using namespace scm_details;
+
+            auto guard = ReadGuard(_slot);
+            bindSection(obj, guard.data(), guard.data().getSection(section), true);
+        }
+
+        /**
+         * Fill object members declared with SCM_BIND from section if section exists
+         * Members with missing keys stay unchanged
+         * @tparam T - object type
+         * @param obj - object to be filled
+         * @param section - section string
+         */
+        template <typename T>
+        void bind_ie(T& obj, const ScmStrView& section) const {
+            using namespace scm_details;
+
+            auto guard = ReadGuard(_slot);
+            auto sect  = guard.data().findSection(section);
+
+            if (sect)
+                bindSection(obj, guard.data(), *sect, false);
+        }
+
+    private:
+        friend class snapshot;
+        friend class key_handle;
+        friend scm_details::CfgData& scm_details::cfg_data();
+
+        scm_details::CfgDataSlot _slot;
+#ifndef SCM_NO_THREADS
+        std::unique_ptr<scm_details::Watcher> _watcher; // Stopped before data is destroyed
+#endif
+    };
+
     /**
-     * Parse config file and all includes
+     * Config used by free functions
+     */
+    IA default_config() -> config& {
+        static config cfg;
+        return cfg;
+    }
+
+    inline auto key_handle::resolve() const -> const scm_details::Value* {
+        auto guard = scm_details::ReadGuard(default_config()._slot);
+        return resolve(guard.data());
+    }
+
+    /**
+     * Pins current data of config for the calling thread. While snapshot exists, all reads of the config
+     * in this thread see the same version even if it is replaced by watcher, parse or reload in other thread,
+     * and strings and references returned by reads stay valid.
+     * Without snapshot they stay valid until config is replaced
+     */
+    class snapshot {
+    public:
+        explicit snapshot(const config& cfg = default_config()): _guard(cfg._slot) {}
+
+    private:
+        scm_details::ReadGuard _guard;
+    };
+
+    /**
+     * Parse config file and all includes, see config::parse
      * @param filepath - path to file
+     * @param mode - parse mode
      */
-    IA parse(const ScmStrView& filepath) {
-        scm_details::parse(filepath);
+    IA parse(const ScmStrView& filepath, parse_mode mode = parse_mode::text) {
+        default_config().parse(filepath, mode);
+    }
+
+    /**
+     * Save parsed data to compiled cache '<filepath>.scmc', see config::save_cache
+     * @param filepath - path to config file, data must be parsed from this file only
+     */
+    IA save_cache(const ScmStrView& filepath) {
+        default_config().save_cache(filepath);
     }
 
     /**
      * Clear config data
      */
     IA clear() {
-        scm_details::cfg_data().clear();
+        default_config().clear();
+    }
+
+    /**
+     * Parse config file again, see config::reload
+     */
+    IA reload(const ScmStrView& filepath, parse_mode mode = parse_mode::text) {
+        default_config().reload(filepath, mode);
+    }
+
+    /**
+     * Store inherited values in the section itself, see config::materialize
+     */
+    IA materialize(const ScmStrView& section) {
+        default_config().materialize(section);
+    }
+
+    /**
+     * Make config read-only and index all values by perfect hash, see config::freeze
+     */
+    IA freeze() {
+        default_config().freeze();
+    }
+
+    /**
+     * Allow changes of frozen config again
+     */
+    IA thaw() {
+        default_config().thaw();
+    }
+
+    /**
+     * @return true if config is frozen
+     */
+    IA is_frozen() {
+        return default_config().is_frozen();
     }
 
+#ifndef SCM_NO_THREADS
     /**
-     * Clear data and parse config file
+     * Watch config file and all its includes, see config::watch
+     * @param filepath - path to file, current data must be parsed from it
+     * @param mode - parse mode
+     * @param callback - called from watcher thread after every parse with nullptr on success
+     * or with exception thrown by parser
      */
-    IA reload(const ScmStrView& filepath) {
-        clear();
-        parse(filepath);
+    IA watch(const ScmStrView& filepath, parse_mode mode = parse_mode::text,
+             std::function<void(std::exception_ptr)> callback = {}) {
+        default_config().watch(filepath, mode, std::move(callback));
     }
 
+    /**
+     * Stop watching and free replaced data which isn't read anymore
+     */
+    IA unwatch() {
+        default_config().unwatch();
+    }
+#endif
+
     /**
      * Check is section exists
      * @param section - section for checking
      * @return true if exists otherwise false
      */
     IA is_section_exists(const ScmStrView& section) {
-        using namespace scm_details;
-
-        return cfg_data().isSectionExists(String(section));
+        return default_config().is_section_exists(section);
     }
 
     /**
@@ -52,14 +944,7 @@ namespace SCM_NAMESPACE {
      * @return true if key exists in section, false if not or section doesn't exist too
      */
     IA is_key_exists(const ScmStrView& key, const ScmStrView& section = scm_details::GLOBAL_NAMESPACE) {
-        using namespace scm_details;
-
-        auto sect = cfg_data().sectionOpt(String(section));
-
-        if (sect)
-            return sect->isExists(String(key));
-        else
-            return false;
+        return default_config().is_key_exists(key, section);
     }
 
     /**
@@ -71,9 +956,52 @@ namespace SCM_NAMESPACE {
      */
     template <typename T>
     IA read(const ScmStrView& key, const ScmStrView& section = scm_details::GLOBAL_NAMESPACE) {
-        using namespace scm_details;
+        return default_config().read<T>(key, section);
+    }
+
+    /**
+     * Check is key exists
+     * @param handle - key handle
+     * @return true if key exists in section, false if not or section doesn't exist too
+     */
+    IA is_key_exists(const key_handle& handle) {
+        return default_config().is_key_exists(handle);
+    }
 
-        return superCast<T>(cfg_data().getValue(String(section), String(key)), key, section);
+    /**
+     * Read one value from cfg by key handle
+     * @tparam T - value type
+     * @param handle - key handle
+     * @return Value with T type
+     */
+    template <typename T>
+    IA read(const key_handle& handle) {
+        return default_config().read<T>(handle);
+    }
+
+    /**
+     * Read two ore more values from cfg by key handle
+     * @tparam T1 - type of first value
+     * @tparam T2 - type of second value
+     * @tparam Ts - type of other values
+     * @param handle - key handle
+     * @return Tuple of read values
+     */
+    template <typename T1, typename T2, typename... Ts>
+    IA read(const key_handle& handle) {
+        return default_config().read<T1, T2, Ts...>(handle);
+    }
+
+    /**
+     * Read one value from cfg by key handle if key or section exists
+     * @tparam T - value type
+     * @param handle - key handle
+     * @param default_val - default value
+     * @return Value with T type or default_val if key or section doesn't exists
+     */
+    template <typename T>
+    IA read_ie(const key_handle& handle, const T& default_val) {
+        return default_config().read_ie<T>(handle, default_val);
     }
 
     /**
@@ -87,13 +1015,58 @@ namespace SCM_NAMESPACE {
      */
     template <typename T1, typename T2, typename... Ts>
     IA read(const ScmStrView& key, const ScmStrView& section = scm_details::GLOBAL_NAMESPACE) {
-        using namespace scm_details;
+        return default_config().read<T1, T2, Ts...>(key, section);
+    }
 
-        auto str = cfg_data().getValue(String(section), String(key));
-        auto vec = unpack(key, section, str, sizeof...(Ts) + 2);
-        auto is  = std::make_index_sequence<sizeof...(Ts) + 2>();
+    /**
+     * Read one value from cfg and cache converted result, see config::read_cached
+     * @tparam T - value type
+     * @param key - value key
+     * @param section - section name. If unused - perform read from global namespace
+     * @return Reference to value with T type, valid while snapshot exists or until config is replaced
+     */
+    template <typename T>
+    IA read_cached(const ScmStrView& key, const ScmStrView& section = scm_details::GLOBAL_NAMESPACE) -> const T& {
+        return default_config().read_cached<T>(key, section);
+    }
 
-        return readTupleImpl<T1, T2, Ts...>(vec, key, section, is);
+    /**
+     * Read one value from cfg by key handle and cache converted result
+     * @tparam T - value type
+     * @param handle - key handle
+     * @return Reference to value with T type, valid while snapshot exists or until config is replaced
+     */
+    template <typename T>
+    IA read_cached(const key_handle& handle) -> const T& {
+        return default_config().read_cached<T>(handle);
+    }
+
+    /**
+     * Read list of values directly into memory without intermediate containers
+     * @tparam T - element type
+     * @param data - output buffer
+     * @param size - buffer size. Exception if list contains more values
+     * @param key - value key
+     * @param section - section name. If unused - perform read from global namespace
+     * @return Number of read values
+     */
+    template <typename T>
+    IA read_into(T* data, ScmSizeT size, const ScmStrView& key,
+                 const ScmStrView& section = scm_details::GLOBAL_NAMESPACE) -> ScmSizeT {
+        return default_config().read_into(data, size, key, section);
+    }
+
+    /**
+     * Read list of values into output iterator without intermediate containers
+     * @tparam T - element type
+     * @param out - output iterator
+     * @param key - value key
+     * @param section - section name. If unused - perform read from global namespace
+     * @return Output iterator past the last written value
+     */
+    template <typename T, typename OutIt>
+    IA read_into(OutIt out, const ScmStrView& key, const ScmStrView& section = scm_details::GLOBAL_NAMESPACE) {
+        return default_config().read_into<T>(out, key, section);
     }
 
     /**
@@ -106,14 +1079,7 @@ namespace SCM_NAMESPACE {
      */
     template <typename T>
     IA read_ie(const ScmStrView& key, const ScmStrView& section, const T& default_val) {
-        using namespace scm_details;
-
-        auto str = cfg_data().valueOpt(String(section), String(key));
-
-        if (str)
-            return superCast<T>(*str, key, section);
-        else
-            return default_val;
+        return default_config().read_ie<T>(key, section, default_val);
     }
 
     /**
@@ -132,19 +1098,7 @@ namespace SCM_NAMESPACE {
     IA read_ie(const ScmStrView& key, const ScmStrView& section,
             const T1& def_val1, const T2& def_val2, const Ts& ... default_vals)
     {
-        using namespace scm_details;
-
-        auto str = cfg_data().valueOpt(String(section), String(key));
-
-        if (str) {
-            auto vec = unpack(key, section, *str, sizeof...(Ts) + 2);
-            auto is = std::make_index_sequence<sizeof...(Ts) + 2>();
-
-            return readTupleImpl<T1, T2, Ts...>(vec, key, section, is);
-        }
-        else {
-            return std::make_tuple(default_vals...);
-        }
+        return default_config().read_ie<T1, T2, Ts...>(key, section, def_val1, def_val2, default_vals...);
     }
 
     /**
@@ -175,15 +1129,7 @@ namespace SCM_NAMESPACE {
      */
     template <typename T>
     IA read_ike(const ScmStrView& key, const ScmStrView& section, const T& default_val) {
-        using namespace scm_details;
-
-        auto sect = cfg_data().getSection(String(section));
-        auto str  = sect.valueOpt(String(key));
-
-        if (str)
-            return superCast<T>(*str, key, section);
-        else
-            return default_val;
+        return default_config().read_ike<T>(key, section, default_val);
     }
 
     /**
@@ -202,20 +1148,7 @@ namespace SCM_NAMESPACE {
     IA read_ike(const ScmStrView& key, const ScmStrView& section,
                 const T1& def_val1, const T2& def_val2, const Ts& ... default_vals)
     {
-        using namespace scm_details;
-
-        auto sect = cfg_data().getSection(String(section));
-        auto str  = sect.valueOpt(String(key));
-
-        if (str) {
-            auto vec = unpack(key, section, *str, sizeof...(Ts) + 2);
-            auto is = std::make_index_sequence<sizeof...(Ts) + 2>();
-
-            return readTupleImpl<T1, T2, Ts...>(vec, key, section, is);
-        }
-        else {
-            return std::make_tuple(default_vals...);
-        }
+        return default_config().read_ike<T1, T2, Ts...>(key, section, def_val1, def_val2, default_vals...);
     }
 
     /**
@@ -248,6 +1181,30 @@ namespace SCM_NAMESPACE {
         val = read<T>(key, section);
     }
 
+    /**
+     * Set value from config by key handle
+     * @tparam T - value type
+     * @param val - value to be set
+     * @param handle - key handle
+     */
+    template <typename T>
+    IA set(T& val, const key_handle& handle) {
+        val = read<T>(handle);
+    }
+
+    /**
+     * Set value from config by key handle if section or key exists. Otherwise set default_value
+     * @tparam T - value type
+     * @tparam D - default value type
+     * @param val - value to be set
+     * @param handle - key handle
+     * @param default_value - default value
+     */
+    template <typename T, typename D>
+    IA set_ie(T& val, const key_handle& handle, const D& default_value) {
+        val = read_ie<T>(handle, T(default_value));
+    }
+
     /**
      * Set value from config if section or key exists. Otherwise set default_value
      * @tparam T - value type
@@ -305,8 +1262,95 @@ namespace SCM_NAMESPACE {
 
         set_ike<T>(val, key, GLOBAL_NAMESPACE, T(default_value));
     }
+
+    /**
+     * Fill object members declared with SCM_BIND from section
+     * All members are read with a single section lookup, errors are reported at once
+     * @tparam T - object type
+     * @param obj - object to be filled
+     * @param section - section string
+     */
+    template <typename T>
+    IA bind(T& obj, const ScmStrView& section) {
+        default_config().bind(obj, section);
+    }
+
+    /**
+     * Fill object members declared with SCM_BIND from section if section exists
+     * Members with missing keys stay unchanged
+     * @tparam T - object type
+     * @param obj - object to be filled
+     * @param section - section string
+     */
+    template <typename T>
+    IA bind_ie(T& obj, const ScmStrView& section) {
+        default_config().bind_ie(obj, section);
+    }
 } // namespace SCM_NAMESPACE
 
+namespace scm_details {
+    inline CfgData& cfg_data() {
+        return SCM_NAMESPACE::default_config()._slot.get();
+    }
+} // namespace scm_details
+
+// Applies M(A, X) to each of up to 32 arguments, comma separated
+#define SCM_DETAILS_EXPAND(X) X
+#define SCM_DETAILS_FE_1(M, A, X) M(A, X)
+#define SCM_DETAILS_FE_2(M, A, X, ...) M(A, X), SCM_DETAILS_EXPAND(SCM_DETAILS_FE_1(M, A, __VA_ARGS__))
+#define SCM_DETAILS_FE_3(M, A, X, ...) M(A, X), SCM_DETAILS_EXPAND(SCM_DETAILS_FE_2(M, A, __VA_ARGS__))
+#define SCM_DETAILS_FE_4(M, A, X, ...) M(A, X), SCM_DETAILS_EXPAND(SCM_DETAILS_FE_3(M, A, __VA_ARGS__))
+#define SCM_DETAILS_FE_5(M, A, X, ...) M(A, X), SCM_DETAILS_EXPAND(SCM_DETAILS_FE_4(M, A, __VA_ARGS__))
+#define SCM_DETAILS_FE_6(M, A, X, ...) M(A, X), SCM_DETAILS_EXPAND(SCM_DETAILS_FE_5(M, A, __VA_ARGS__))
+#define SCM_DETAILS_FE_7(M, A, X, ...) M(A, X), SCM_DETAILS_EXPAND(SCM_DETAILS_FE_6(M, A, __VA_ARGS__))
+#define SCM_DETAILS_FE_8(M, A, X, ...) M(A, X), SCM_DETAILS_EXPAND(SCM_DETAILS_FE_7(M, A, __VA_ARGS__))
+#define SCM_DETAILS_FE_9(M, A, X, ...) M(A, X), SCM_DETAILS_EXPAND(SCM_DETAILS_FE_8(M, A, __VA_ARGS__))
+#define SCM_DETAILS_FE_10(M, A, X, ...) M(A, X), SCM_DETAILS_EXPAND(SCM_DETAILS_FE_9(M, A, __VA_ARGS__))
+#define SCM_DETAILS_FE_11(M, A, X, ...) M(A, X), SCM_DETAILS_EXPAND(SCM_DETAILS_FE_10(M, A, __VA_ARGS__))
+#define SCM_DETAILS_FE_12(M, A, X, ...) M(A, X), SCM_DETAILS_EXPAND(SCM_DETAILS_FE_11(M, A, __VA_ARGS__))
+#define SCM_DETAILS_FE_13(M, A, X, ...) M(A, X), SCM_DETAILS_EXPAND(SCM_DETAILS_FE_12(M, A, __VA_ARGS__))
+#define SCM_DETAILS_FE_14(M, A, X, ...) M(A, X), SCM_DETAILS_EXPAND(SCM_DETAILS_FE_13(M, A, __VA_ARGS__))
+#define SCM_DETAILS_FE_15(M, A, X, ...) M(A, X), SCM_DETAILS_EXPAND(SCM_DETAILS_FE_14(M, A, __VA_ARGS__))
+#define SCM_DETAILS_FE_16(M, A, X, ...) M(A, X), SCM_DETAILS_EXPAND(SCM_DETAILS_FE_15(M, A, __VA_ARGS__))
+#define SCM_DETAILS_FE_17(M, A, X, ...) M(A, X), SCM_DETAILS_EXPAND(SCM_DETAILS_FE_16(M, A, __VA_ARGS__))
+#define SCM_DETAILS_FE_18(M, A, X, ...) M(A, X), SCM_DETAILS_EXPAND(SCM_DETAILS_FE_17(M, A, __VA_ARGS__))
+#define SCM_DETAILS_FE_19(M, A, X, ...) M(A, X), SCM_DETAILS_EXPAND(SCM_DETAILS_FE_18(M, A, __VA_ARGS__))
+#define SCM_DETAILS_FE_20(M, A, X, ...) M(A, X), SCM_DETAILS_EXPAND(SCM_DETAILS_FE_19(M, A, __VA_ARGS__))
+#define SCM_DETAILS_FE_21(M, A, X, ...) M(A, X), SCM_DETAILS_EXPAND(SCM_DETAILS_FE_20(M, A, __VA_ARGS__))
+#define SCM_DETAILS_FE_22(M, A, X, ...) M(A, X), SCM_DETAILS_EXPAND(SCM_DETAILS_FE_21(M, A, __VA_ARGS__))
+#define SCM_DETAILS_FE_23(M, A, X, ...) M(A, X), SCM_DETAILS_EXPAND(SCM_DETAILS_FE_22(M, A, __VA_ARGS__))
+#define SCM_DETAILS_FE_24(M, A, X, ...) M(A, X), SCM_DETAILS_EXPAND(SCM_DETAILS_FE_23(M, A, __VA_ARGS__))
+#define SCM_DETAILS_FE_25(M, A, X, ...) M(A, X), SCM_DETAILS_EXPAND(SCM_DETAILS_FE_24(M, A, __VA_ARGS__))
+#define SCM_DETAILS_FE_26(M, A, X, ...) M(A, X), SCM_DETAILS_EXPAND(SCM_DETAILS_FE_25(M, A, __VA_ARGS__))
+#define SCM_DETAILS_FE_27(M, A, X, ...) M(A, X), SCM_DETAILS_EXPAND(SCM_DETAILS_FE_26(M, A, __VA_ARGS__))
+#define SCM_DETAILS_FE_28(M, A, X, ...) M(A, X), SCM_DETAILS_EXPAND(SCM_DETAILS_FE_27(M, A, __VA_ARGS__))
+#define SCM_DETAILS_FE_29(M, A, X, ...) M(A, X), SCM_DETAILS_EXPAND(SCM_DETAILS_FE_28(M, A, __VA_ARGS__))
+#define SCM_DETAILS_FE_30(M, A, X, ...) M(A, X), SCM_DETAILS_EXPAND(SCM_DETAILS_FE_29(M, A, __VA_ARGS__))
+#define SCM_DETAILS_FE_31(M, A, X, ...) M(A, X), SCM_DETAILS_EXPAND(SCM_DETAILS_FE_30(M, A, __VA_ARGS__))
+#define SCM_DETAILS_FE_32(M, A, X, ...) M(A, X), SCM_DETAILS_EXPAND(SCM_DETAILS_FE_31(M, A, __VA_ARGS__))
+#define SCM_DETAILS_FE_GET(_1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13, _14, _15, _16, _17, _18, _19, _20, _21, _22, _23, _24, _25, _26, _27, _28, _29, _30, _31, _32, NAME, ...) NAME
+#define SCM_DETAILS_FOR_EACH(M, A, ...) \
+SCM_DETAILS_EXPAND(SCM_DETAILS_FE_GET(__VA_ARGS__, \
+    SCM_DETAILS_FE_32, SCM_DETAILS_FE_31, SCM_DETAILS_FE_30, SCM_DETAILS_FE_29, SCM_DETAILS_FE_28, SCM_DETAILS_FE_27, SCM_DETAILS_FE_26, SCM_DETAILS_FE_25, \
+    SCM_DETAILS_FE_24, SCM_DETAILS_FE_23, SCM_DETAILS_FE_22, SCM_DETAILS_FE_21, SCM_DETAILS_FE_20, SCM_DETAILS_FE_19, SCM_DETAILS_FE_18, SCM_DETAILS_FE_17, \
+    SCM_DETAILS_FE_16, SCM_DETAILS_FE_15, SCM_DETAILS_FE_14, SCM_DETAILS_FE_13, SCM_DETAILS_FE_12, SCM_DETAILS_FE_11, SCM_DETAILS_FE_10, SCM_DETAILS_FE_9, \
+    SCM_DETAILS_FE_8, SCM_DETAILS_FE_7, SCM_DETAILS_FE_6, SCM_DETAILS_FE_5, SCM_DETAILS_FE_4, SCM_DETAILS_FE_3, SCM_DETAILS_FE_2, SCM_DETAILS_FE_1)(M, A, __VA_ARGS__))
+
+#define SCM_DETAILS_BIND_FIELD(TYPE, VALUE) \
+::scm_details::makeBindField(#VALUE, &TYPE::_##VALUE)
+
+/**
+ * Declare class members that can be filled with SCM_NAMESPACE::bind / SCM_NAMESPACE::bind_ie
+ * Must be placed inside the class. Doesn't change access of following members
+ * Members must have same name as cfg key, but with '_' prefix
+ * @param TYPE - class name
+ * @param ... - values to be set without '_' (cfg keys), up to 32
+ */
+#define SCM_BIND(TYPE, ...) \
+friend auto scm_bind_fields(const TYPE*) { \
+    return std::make_tuple(SCM_DETAILS_FOR_EACH(SCM_DETAILS_BIND_FIELD, TYPE, __VA_ARGS__)); \
+}
+
 /**
  * Set class member from cfg
  * Member must have same name as cfg key, but with '_' prefix
@@ -1,7 +1,13 @@
 #pragma once
 
+#include <limits>
+#include <cstdint>
+#include <cstdlib>
+#include <charconv>
+#include <cstring>
 #include <type_traits>
 #include "scm_utils.hpp"
+#include "scm_aton_pow5.hpp"
 
 #define white_space(c) ((c) == ' ' || (c) == '\t')
 #define valid_digit(c) ((c) >= '0' && (c) <= '9')
@@ -10,149 +16,508 @@
     #define SCM_NAMESPACE scm
 #endif
 
+namespace scm_details {
+    // Powers of ten exactly representable in double and float
+    inline constexpr double POW10_F64[] = {
+        1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+    inline constexpr float POW10_F32[] = {
+        1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f
+    };
+
+    /**
+     * Load 8 chars as little-endian 64-bit word
+     */
+    inline auto loadEightChars(const char* p) -> std::uint64_t {
+        std::uint64_t v;
+        std::memcpy(&v, p, sizeof(v));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        v = __builtin_bswap64(v);
+#endif
+        return v;
+    }
+
+    /**
+     * Check that all 8 chars of word are decimal digits (SWAR)
+     */
+    inline bool isEightDigits(std::uint64_t v) {
+        return ((v & 0xF0F0F0F0F0F0F0F0) | (((v + 0x0606060606060606) & 0xF0F0F0F0F0F0F0F0) >> 4)) ==
+               0x3333333333333333;
+    }
+
+    /**
+     * Convert 8 decimal digits to number with three multiplications (SWAR)
+     */
+    inline auto parseEightDigits(std::uint64_t v) -> std::uint32_t {
+        constexpr std::uint64_t mask = 0x000000FF000000FF;
+        constexpr std::uint64_t mul1 = 0x000F424000000064; // 100 + (1000000 << 32)
+        constexpr std::uint64_t mul2 = 0x0000271000000001; // 1 + (10000 << 32)
+
+        v -= 0x3030303030303030;
+        v  = (v * 10) + (v >> 8);
+        v  = (((v & mask) * mul1) + (((v >> 16) & mask) * mul2)) >> 32;
+
+        return static_cast<std::uint32_t>(v);
+    }
+
+    /**
+     * Accumulate decimal digits to 'value', 8 digits at a time while possible
+     * Value wraps if there are more than 19 digits
+     * @return pointer to first non-digit char
+     */
+    inline auto accumulateDigits(const char* p, const char* end, std::uint64_t& value) -> const char* {
+        while (end - p >= 8) {
+            auto v = loadEightChars(p);
+            if (!isEightDigits(v))
+                break;
+
+            value = value * 100000000 + parseEightDigits(v);
+            p += 8;
+        }
+
+        while (p != end && *p >= '0' && *p <= '9') {
+            value = value * 10 + static_cast<std::uint64_t>(*p - '0');
+            ++p;
+        }
+
+        return p;
+    }
+
+    /**
+     * Parse decimal digits, 8 at a time while possible
+     * @param overflow - set if number doesn't fit 64 bits
+     * @return pointer to first non-digit char
+     */
+    inline auto parseDecimal(const char* p, const char* end, std::uint64_t& value, bool& overflow) -> const char* {
+        auto start = p;
+        p = accumulateDigits(p, end, value);
+
+        // Up to 19 digits always fit. 20 digits fit only if number starts with '1',
+        // otherwise it wraps below 2^63
+        if (p - start >= 20) {
+            while (start != p && *start == '0') { ++start; }
+
+            auto count = p - start;
+            overflow = count > 20 || (count == 20 && (*start != '1' || value <= 0x7FFFFFFFFFFFFFFF));
+        }
+
+        return p;
+    }
+
+    inline auto hexDigit(char c) -> unsigned {
+        if (c >= '0' && c <= '9') return static_cast<unsigned>(c - '0');
+        if (c >= 'a' && c <= 'f') return static_cast<unsigned>(c - 'a' + 10);
+        if (c >= 'A' && c <= 'F') return static_cast<unsigned>(c - 'A' + 10);
+        return 16;
+    }
+
+    inline bool isRadixPrefix(const char* p, const char* end) {
+        return end - p >= 3 && p[0] == '0' && (p[1] == 'x' || p[1] == 'X' || p[1] == 'b' || p[1] == 'B');
+    }
+
+    /**
+     * Parse '0x' with hex digits or '0b' with binary digits
+     * @param overflow - set if number doesn't fit 64 bits
+     * @return pointer to first char after number or p if there are no digits
+     */
+    inline auto parseRadix(const char* p, const char* end, std::uint64_t& value, bool& overflow) -> const char* {
+        auto bits  = (p[1] == 'x' || p[1] == 'X') ? 4u : 1u;
+        auto start = p + 2;
+        auto used  = 0u;
+
+        for (p = start; p != end; ++p) {
+            auto digit = hexDigit(*p);
+            if (digit >> bits)
+                break;
+
+            if (value != 0 || digit != 0)
+                used += bits;
+
+            value = (value << bits) | digit;
+        }
+
+        overflow = used > 64;
+
+        return p != start ? p : start - 2;
+    }
+
+    /**
+     * Clinger's fast path: mantissa and power of ten are both exact, so one
+     * multiplication or division gives correctly rounded result
+     * @return true if result was computed
+     */
+    template <typename T>
+    bool atonFastPath(std::uint64_t mantissa, std::int64_t exp10, T& result) {
+        if constexpr (std::is_same_v<T, double>) {
+            if (mantissa > (1ULL << 53) || exp10 < -22 || exp10 > 22)
+                return false;
+
+            auto m = static_cast<double>(mantissa);
+            result = exp10 < 0 ? m / POW10_F64[-exp10] : m * POW10_F64[exp10];
+            return true;
+        }
+        else if constexpr (std::is_same_v<T, float>) {
+            if (mantissa > (1ULL << 24) || exp10 < -10 || exp10 > 10)
+                return false;
+
+            auto m = static_cast<float>(mantissa);
+            result = exp10 < 0 ? m / POW10_F32[-exp10] : m * POW10_F32[exp10];
+            return true;
+        }
+        else {
+            return false;
+        }
+    }
+
+#if defined(__SIZEOF_INT128__)
+    // __extension__ keeps -pedantic quiet about non-standard type
+    __extension__ typedef unsigned __int128 Uint128;
+#endif
+
+    /**
+     * 64x64 -> 128 bit multiplication
+     * @return high word, low word is stored to 'low'
+     */
+    inline auto mulHigh64(std::uint64_t a, std::uint64_t b, std::uint64_t& low) -> std::uint64_t {
+#if defined(__SIZEOF_INT128__)
+        auto r = static_cast<Uint128>(a) * b;
+        low = static_cast<std::uint64_t>(r);
+        return static_cast<std::uint64_t>(r >> 64);
+#elif defined(_MSC_VER) && defined(_M_X64)
+        auto high = std::uint64_t(0);
+        low = _umul128(a, b, &high);
+        return high;
+#else
+        auto aLo = a & 0xFFFFFFFF, aHi = a >> 32;
+        auto bLo = b & 0xFFFFFFFF, bHi = b >> 32;
+        auto ll  = aLo * bLo, lh = aLo * bHi, hl = aHi * bLo, hh = aHi * bHi;
+        auto mid = (ll >> 32) + (lh & 0xFFFFFFFF) + (hl & 0xFFFFFFFF);
+        low = (mid << 32) | (ll & 0xFFFFFFFF);
+        return hh + (lh >> 32) + (hl >> 32) + (mid >> 32);
+#endif
+    }
+
+    inline int leadingZeros64(std::uint64_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+        return __builtin_clzll(x);
+#else
+        int n = 0;
+        while (!(x & (1ULL << 63))) { x <<= 1; ++n; }
+        return n;
+#endif
+    }
+
+    /**
+     * Eisel-Lemire algorithm: correctly rounded mantissa * 10^exp10 for mantissa with up to 19 digits
+     * See D. Lemire, "Number Parsing at a Gigabyte per Second" and N. Mushtak, D. Lemire,
+     * "Fast Number Parsing Without Fallback"
+     * @return true if result was computed (always for float and double)
+     */
+    template <typename T>
+    bool atonEiselLemire(std::uint64_t mantissa, std::int64_t exp10, T& result) {
+        constexpr bool isDouble = std::is_same_v<T, double>;
+
+        if constexpr (!isDouble && !std::is_same_v<T, float>) {
+            return false;
+        }
+        else {
+            using Bits = std::conditional_t<isDouble, std::uint64_t, std::uint32_t>;
+
+            constexpr int  mantissaBits     = isDouble ? 52 : 23;
+            constexpr int  minExponent      = isDouble ? -1023 : -127;
+            constexpr int  infinitePower    = isDouble ? 0x7FF : 0xFF;
+            constexpr int  smallestPower    = isDouble ? -342 : -65;
+            constexpr int  largestPower     = isDouble ? 308 : 38;
+            constexpr int  minRoundToEven   = isDouble ? -4 : -17;
+            constexpr int  maxRoundToEven   = isDouble ? 23 : 10;
+            constexpr auto precisionMask    = ~std::uint64_t(0) >> (mantissaBits + 3);
+
+            std::uint64_t m     = 0;
+            std::int64_t  power = 0;
+
+            if (mantissa == 0 || exp10 < smallestPower) {
+                m = 0; power = 0;
+            }
+            else if (exp10 > largestPower) {
+                m = 0; power = infinitePower;
+            }
+            else {
+                auto lz = leadingZeros64(mantissa);
+                mantissa <<= lz;
+
+                // Product with 128-bit power of five, low word is needed only near the halfway point
+                auto index = 2 * static_cast<ScmSizeT>(exp10 - SMALLEST_POWER_OF_FIVE);
+                auto low   = std::uint64_t(0);
+                auto high  = mulHigh64(mantissa, POWER_OF_FIVE_128[index], low);
+
+                if ((high & precisionMask) == precisionMask) {
+                    auto low2  = std::uint64_t(0);
+                    auto high2 = mulHigh64(mantissa, POWER_OF_FIVE_128[index + 1], low2);
+
+                    low += high2;
+                    if (high2 > low)
+                        ++high;
+                }
+
+                auto upperBit = static_cast<int>(high >> 63);
+                auto shift    = upperBit + 64 - mantissaBits - 3;
+
+                m     = high >> shift;
+                power = ((((152170 + 65536) * exp10) >> 16) + 63) + upperBit - lz - minExponent;
+
+                if (power <= 0) {
+                    // Subnormal
+                    if (-power + 1 >= 64) {
+                        m = 0; power = 0;
+                    }
+                    else {
+                        m >>= -power + 1;
+                        m += m & 1;
+                        m >>= 1;
+                        power = m < (std::uint64_t(1) << mantissaBits) ? 0 : 1;
+                    }
+                }
+                else {
+                    // Exactly halfway between two floats: round to even
+                    if (low <= 1 && exp10 >= minRoundToEven && exp10 <= maxRoundToEven &&
+                        (m & 3) == 1 && (m << shift) == high)
+                        m &= ~std::uint64_t(1);
+
+                    m += m & 1;
+                    m >>= 1;
+
+                    if (m >= (std::uint64_t(2) << mantissaBits)) {
+                        m = std::uint64_t(1) << mantissaBits;
+                        ++power;
+                    }
+
+                    m &= ~(std::uint64_t(1) << mantissaBits);
+
+                    if (power >= infinitePower) {
+                        m = 0; power = infinitePower;
+                    }
+                }
+            }
+
+            auto bits = static_cast<Bits>(m | (static_cast<std::uint64_t>(power) << mantissaBits));
+            std::memcpy(&result, &bits, sizeof(result));
+            return true;
+        }
+    }
+
+    /**
+     * Correctly rounded conversion of validated unsigned decimal number with any count of digits
+     */
+    template <typename T>
+    auto atonSlowPath(const char* begin, const char* end) -> T {
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+        auto result = T(0);
+        auto [ptr, ec] = std::from_chars(begin, end, result, std::chars_format::general);
+
+        if (ec == std::errc() && ptr == end)
+            return result;
+#endif
+        // Out of range (strtod gives inf, zero or subnormal) or from_chars is unavailable
+        auto buf = std::string(begin, end);
+
+        if constexpr (std::is_same_v<T, float>)
+            return std::strtof(buf.data(), nullptr);
+        else if constexpr (std::is_same_v<T, double>)
+            return std::strtod(buf.data(), nullptr);
+        else
+            return static_cast<T>(std::strtold(buf.data(), nullptr));
+    }
+} // namespace scm_details
+
 namespace SCM_NAMESPACE {
+
+    /**
+     * Convert string to floating point number, result is correctly rounded
+     * Format: [spaces][+-]digits[.digits][(e|E)[+-]digits]
+     */
     template<typename T>
     auto aton(const ScmStrView& str, const ScmStrView& name, const ScmStrView& section)
     -> std::enable_if_t<std::is_floating_point_v<T>, T>
     {
-        auto p = str.cbegin();
+        auto p   = str.data();
+        auto end = p + str.size();
 
-        while (white_space(*p) && p != str.end()) { ++p; }
-
-        auto r = static_cast<T>(0);
+        while (p != end && white_space(*p)) { ++p; }
 
         // Get sign
         bool neg = false;
-        if (*p == '-' && p != str.end()) {
-            neg = true;
+        if (p != end && (*p == '-' || *p == '+')) {
+            neg = *p == '-';
             ++p;
         }
-        else if (*p == '+' && p != str.end()) {
-            neg = false;
+
+        auto start = p;
+
+        // Get the digits before and after decimal point. Mantissa is exact if there are no more than 19 digits
+        std::uint64_t mantissa = 0;
+
+        // Integer part is usually short, so SWAR is used only for fraction
+        auto intBegin = p;
+        while (p != end && valid_digit(*p)) {
+            mantissa = mantissa * 10 + static_cast<std::uint64_t>(*p - '0');
             ++p;
         }
+        auto intEnd = p;
 
-        // Get the digits before decimal point
-        while (valid_digit(*p) && p != str.end()) {
-            r = (r * 10) + (*p - '0');
-            ++p;
+        auto fracBegin = p, fracEnd = p;
+        if (p != end && *p == '.') {
+            fracBegin = ++p;
+            fracEnd   = p = scm_details::accumulateDigits(p, end, mantissa);
         }
 
-        SCM_EXCEPTION(ScmAtonException, p != str.cbegin(),
-                      "Invalid digit '", std::string(1, *p), "' in float '",
+        SCM_EXCEPTION(ScmAtonException, intBegin != intEnd || fracBegin != fracEnd,
+                      "Invalid digit '", p != end ? std::string(1, *p) : std::string(), "' in float '",
                       name, "' in section [", section, "]");
 
-        // Get the digits after decimal point
-        if (*p == '.' && p != str.end()) {
-            T f = 0.0;
-            std::size_t scale = 1;
-            ++p;
-            while (valid_digit(*p) && p != str.end()) {
-                f = (f * 10) + (*p - '0');
-                ++p;
-                scale *= 10;
-            }
-            r += f / static_cast<T>(scale);
-        }
-
-        // Get the digits after the "e"/"E" (exponenet)
-        if ((*p == 'e' || *p == 'E') && p != str.end()) {
-            std::ptrdiff_t e = 0;
+        std::int64_t exp10 = -(fracEnd - fracBegin);
 
-            bool negE = false;
+        // Get the digits after the "e"/"E" (exponent)
+        if (p != end && (*p == 'e' || *p == 'E')) {
             ++p;
 
-            if (p != str.end()) {
-                if      (*p == '-') { negE = true;  ++p; }
-                else if (*p == '+') { negE = false; ++p; }
+            bool negE = false;
+            if (p != end && (*p == '-' || *p == '+')) {
+                negE = *p == '-';
+                ++p;
             }
 
             auto st = p;
+            std::int64_t e = 0;
 
-            while (valid_digit(*p) && p != str.end()) { e = (e * 10) + (*p - '0'); ++p; }
+            while (p != end && valid_digit(*p)) {
+                if (e < 100000)
+                    e = e * 10 + (*p - '0');
+                ++p;
+            }
 
             SCM_EXCEPTION(ScmAtonException, p != st,
                           "Missing number after exponent in float '",
                           name, "' in section [", section, "]");
 
-            if (!neg && e > std::numeric_limits<T>::max_exponent10) {
-                e = std::numeric_limits<T>::max_exponent10;
-            }
-            else if (e < std::numeric_limits<T>::min_exponent10) {
-                e = -std::numeric_limits<T>::min_exponent10;
-            }
+            exp10 += negE ? -e : e;
+        }
 
-            auto scaleE = static_cast<T>(1.0);
-            while (e >= 50) { scaleE *= static_cast<T>(1E50); e -= 50; }
-            while (e > 0) { scaleE *= 10; --e; }
+        SCM_EXCEPTION(ScmAtonException, p == end,
+                      "Invalid digit '", p != end ? std::string(1, *p) : std::string(), "' in float '",
+                      name, "' in section [", section, "]");
+
+        auto r = static_cast<T>(0);
 
-            if (negE) {
-                r /= scaleE;
+        // More than 19 digits: mantissa is exact only if the extra digits are leading zeros
+        if ((intEnd - intBegin) + (fracEnd - fracBegin) > 19) {
+            auto sig = intBegin;
+            while (sig != intEnd && *sig == '0') { ++sig; }
+            if (sig == intEnd) {
+                sig = fracBegin;
+                while (sig != fracEnd && *sig == '0') { ++sig; }
             }
-            else {
-                r *= scaleE;
+
+            auto sigDigits = sig < intEnd ? (intEnd - sig) + (fracEnd - fracBegin) : fracEnd - sig;
+
+            if (sigDigits > 19) {
+                r = scm_details::atonSlowPath<T>(start, end);
+                return neg ? -r : r;
             }
+
+            mantissa = 0;
+            for (auto d = sig; d != fracEnd; ++d)
+                if (d != intEnd)
+                    mantissa = mantissa * 10 + static_cast<std::uint64_t>(*d - '0');
         }
 
-        SCM_EXCEPTION(ScmAtonException, p == str.end() || valid_digit(*p),
-                      "Invalid digit '", std::string(1, *p), "' in float '",
-                      name, "' in section [", section, "]");
+        if (mantissa != 0 &&
+            !scm_details::atonFastPath(mantissa, exp10, r) &&
+            !scm_details::atonEiselLemire(mantissa, exp10, r))
+            r = scm_details::atonSlowPath<T>(start, end);
 
-        if (neg) { r = -r; }
-        return r;
+        return neg ? -r : r;
     }
 
+    /**
+     * Convert string to signed integer
+     * Format: [spaces][+-](digits|0x hex digits|0b binary digits)
+     */
     template<typename T>
     auto aton(const ScmStrView& str, const ScmStrView& name, const ScmStrView& section)
     -> std::enable_if_t<std::is_signed_v<T> && std::is_integral_v<T>, T>
     {
-        auto p = str.cbegin();
-
-        while (white_space(*p) && p != str.end()) { ++p; }
+        auto p   = str.data();
+        auto end = p + str.size();
 
-        auto r = static_cast<T>(0);
+        while (p != end && white_space(*p)) { ++p; }
 
         bool neg = false;
-        if (p != str.end()) {
-            if      (*p == '-') { neg = true;  ++p; }
-            else if (*p == '+') { neg = false; ++p; }
-        }
-
-        while (valid_digit(*p) && p != str.end()) {
-            r = (r * 10) + (*p - '0');
+        if (p != end && (*p == '-' || *p == '+')) {
+            neg = *p == '-';
             ++p;
         }
 
-        SCM_EXCEPTION(ScmAtonException, p == str.end() || valid_digit(*p),
-                      "Invalid digit '", std::string(1, *p), "' in integer '",
-                      name, "' in section [", section, "]");
+        std::uint64_t value    = 0;
+        bool          overflow = false;
+
+        auto digits = p;
+        p = scm_details::isRadixPrefix(p, end) ? scm_details::parseRadix(p, end, value, overflow)
+                                               : scm_details::parseDecimal(p, end, value, overflow);
+
+        auto limit = static_cast<std::uint64_t>(std::numeric_limits<T>::max()) + (neg ? 1 : 0);
+
+        if (p == digits || p != end || overflow || value > limit) {
+            SCM_EXCEPTION(ScmAtonException, p != digits,
+                          "Missing digits in integer '", name, "' in section [", section, "]");
 
-        if (neg) { r = -r; }
-        return r;
+            SCM_EXCEPTION(ScmAtonException, p == end,
+                          "Invalid digit '", p != end ? std::string(1, *p) : std::string(), "' in integer '",
+                          name, "' in section [", section, "]");
+
+            SCM_EXCEPTION(ScmAtonException, 0,
+                          "Integer overflow in '", name, "' in section [", section, "]");
+        }
+
+        // -(max + 1) is representable, but max + 1 isn't
+        return neg && value != 0 ? static_cast<T>(-static_cast<std::int64_t>(value - 1) - 1) : static_cast<T>(value);
     }
 
+    /**
+     * Convert string to unsigned integer
+     * Format: [spaces][+](digits|0x hex digits|0b binary digits)
+     */
     template<typename T>
     auto aton(const ScmStrView& str, const ScmStrView& name, const ScmStrView& section)
     -> std::enable_if_t<std::is_unsigned_v<T>, T>
     {
-        auto p = str.cbegin();
+        auto p   = str.data();
+        auto end = p + str.size();
 
-        while (white_space(*p) && p != str.end()) { ++p; }
+        while (p != end && white_space(*p)) { ++p; }
 
-        auto r = static_cast<T>(0);
+        if (p != end && *p == '+') { ++p; }
 
-        if (*p == '+' && p != str.end()) { ++p; }
+        std::uint64_t value    = 0;
+        bool          overflow = false;
 
-        while (valid_digit(*p) && p != str.end()) {
-            r = (r * 10) + (*p - '0');
-            ++p;
-        }
+        auto digits = p;
+        p = scm_details::isRadixPrefix(p, end) ? scm_details::parseRadix(p, end, value, overflow)
+                                               : scm_details::parseDecimal(p, end, value, overflow);
 
-        SCM_EXCEPTION(ScmAtonException, p == str.end() || valid_digit(*p),
-                      "Invalid digit '", std::string(1, *p), "' in unsigned integer '",
-                      name, "' in section [", section, "]");
+        if (p == digits || p != end || overflow || value > std::numeric_limits<T>::max()) {
+            SCM_EXCEPTION(ScmAtonException, p != digits,
+                          "Missing digits in unsigned integer '", name, "' in section [", section, "]");
+
+            SCM_EXCEPTION(ScmAtonException, p == end,
+                          "Invalid digit '", p != end ? std::string(1, *p) : std::string(), "' in unsigned integer '",
+                          name, "' in section [", section, "]");
+
+            SCM_EXCEPTION(ScmAtonException, 0,
+                          "Integer overflow in '", name, "' in section [", section, "]");
+        }
 
-        return r;
+        return static_cast<T>(value);
     }
 } // namespace SCM_NAMESPACE
 
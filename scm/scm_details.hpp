@@ -1,5 +1,27 @@
 #pragma once
 
+#include <map>
+#include <set>
+#include <memory>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <utility>
+#include <numeric>
+#include <optional>
+#include <algorithm>
+#include <typeindex>
+#include <unordered_map>
+
+#ifndef SCM_NO_THREADS
+    #include <mutex>
+    #include <deque>
+    #include <thread>
+    #include <functional>
+    #include <condition_variable>
+#endif
+#include <future>
+
 #include "scm_utils.hpp"
 #include "scm_types.hpp"
 #include "scm_filesystem.hpp"
@@ -21,29 +43,439 @@ namespace scm_details {
     using StrViewPair   = ScmPair<StrView, StrView>;
     using StrVector     = ScmVector<String>;
     using StrViewVector = ScmVector<StrView>;
-    using StrStrMap     = ScmMap<String, String>;
-    using StrSectionMap = ScmMap<String, class Section>;
+    using StrValueMap   = ScmMap<StrView, class Value>;
+    using StrSectionMap = ScmMap<StrView, std::shared_ptr<class Section>>;
     using CfgException  = SCM_NAMESPACE::CfgException;
 
     static constexpr inline std::string_view GLOBAL_NAMESPACE = "__global";
 
-    void parse (StrViewCref path);
+    class CfgData;
+
+    /**
+     * @param mapped - map files into memory (see file_view), false for files which may be edited during parse
+     */
+    void parse (CfgData& data, StrViewCref path, bool preparse, bool mapped = true);
+
+    /**
+     * Parse again files changed since they were loaded, and units which depend on them (see Unit)
+     * @return false if incremental reload isn't possible and config must be parsed from scratch
+     */
+    bool reloadChanged(CfgData& data, bool preparse);
+
+    /**
+     * @return true if any file which data was parsed from was changed or removed
+     */
+    bool sourcesChanged(const CfgData& data);
+
+    /**
+     * Load compiled cache of config file if it is up to date
+     * @param path - path to config file (not to cache)
+     * @return true if cache was loaded, false if it doesn't exist, is stale or corrupted
+     */
+    bool loadCache(CfgData& data, StrViewCref path);
+
+    /**
+     * Write parsed data to compiled cache of config file
+     * @param path - path to config file (not to cache)
+     */
+    void saveCache(const CfgData& data, StrViewCref path);
+
+    inline auto cachePath(StrViewCref path) -> String {
+        return String(path) + ".scmc";
+    }
 
     auto unpack(StrViewCref name, StrViewCref section, StrViewCref str, SizeT required) -> StrViewVector;
 
-    ////////////////////////////////// Section /////////////////////////////////
+    auto nextElement(StrViewCref name, StrViewCref section, StrViewCref str, SizeT& pos) -> StrView;
 
-    class Section {
+    ////////////////////////////////// Tokens //////////////////////////////////
+
+    enum class TokenType : unsigned char {
+        Section,   // [first]
+        Parent,    // [...] : first
+        Directive, // #first second
+        Key,       // first = <Literal and Reference tokens>
+        Literal,   // Plain or quoted part of value
+        Reference  // $second or $first:second
+    };
+
+    struct Token {
+        TokenType type;
+        SizeT     lineNum;
+        StrView   first;
+        StrView   second;
+    };
+
+    using TokenVector = ScmVector<Token>;
+
+    class Section;
+
+    /**
+     * Value with references. Parser adds it to section as pending value (see ValueType::Pending).
+     * References are resolved after all files are parsed, so a value may be referenced before it is defined
+     */
+    struct Interpolation {
+        StrView  path;
+        Section* section;
+        StrView  key;
+        SizeT    first;   // Range of parts in Interpolations::parts
+        SizeT    count;
+    };
+
+    struct Interpolations {
+        ScmVector<Interpolation> values;
+        TokenVector              parts;  // Literal and Reference tokens, strings are stored in arena
+    };
+
+    /**
+     * Split text to tokens. Comments are dropped and all symbols are validated
+     * in that single pass over each line
+     * @param path - path to file (for diagnostics)
+     * @param text - file content
+     * @return Vector of tokens, views point into the text
+     */
+    auto tokenize(StrViewCref path, StrViewCref text) -> TokenVector;
+
+
+    ///////////////////////////////// Task Pool ////////////////////////////////
+
+    /**
+     * Minimal thread pool for parser tasks. Workers start on the first submit,
+     * so parsing without includes never creates threads.
+     * Tasks must not wait for other tasks. With SCM_NO_THREADS tasks run in place
+     */
+    class TaskPool {
     public:
-        auto getValue(StringCref key) const -> StringCref {
-            auto val = _pairs.find(key);
+        TaskPool() = default;
+        TaskPool(const TaskPool&) = delete;
+        TaskPool& operator= (const TaskPool&) = delete;
+
+        ~TaskPool() {
+#ifndef SCM_NO_THREADS
+            {
+                auto lock = std::lock_guard(_mutex);
+                _stop = true;
+            }
+            _cv.notify_all();
 
-            SCM_EXCEPTION(CfgException, val != _pairs.end(), "Can't find key '", key, "' in section [", _name, "]");
+            for (auto& worker : _workers)
+                worker.join();
+#endif
+        }
 
-            return val->second;
+        template <typename F>
+        auto submit(F&& func) -> std::future<decltype(func())> {
+            auto task   = std::make_shared<std::packaged_task<decltype(func())()>>(std::forward<F>(func));
+            auto future = task->get_future();
+
+#ifdef SCM_NO_THREADS
+            (*task)();
+#else
+            {
+                auto lock = std::lock_guard(_mutex);
+
+                if (_workers.empty()) {
+                    auto count = std::max(std::thread::hardware_concurrency(), 2U);
+                    for (unsigned i = 0; i < count; ++i)
+                        _workers.emplace_back([this] { work(); });
+                }
+
+                _tasks.emplace_back([task] { (*task)(); });
+            }
+            _cv.notify_one();
+#endif
+
+            return future;
+        }
+
+    private:
+#ifndef SCM_NO_THREADS
+        void work() {
+            while (true) {
+                auto task = std::function<void()>();
+                {
+                    auto lock = std::unique_lock(_mutex);
+                    _cv.wait(lock, [this] { return _stop || !_tasks.empty(); });
+
+                    if (_tasks.empty())
+                        return;
+
+                    task = std::move(_tasks.front());
+                    _tasks.pop_front();
+                }
+                task();
+            }
         }
 
-        auto getValue(StringCref key) -> StringRef {
+        std::mutex                        _mutex;
+        std::condition_variable           _cv;
+        std::deque<std::function<void()>> _tasks;
+        std::vector<std::thread>          _workers;
+        bool                              _stop = false;
+#endif
+    };
+
+
+    ///////////////////////////////// File Task ////////////////////////////////
+
+    /**
+     * Size and modification time of file. Used to check that compiled cache is up to date
+     */
+    struct FileStamp {
+        std::uint64_t size  = 0;
+        std::int64_t  mtime = 0;
+
+        bool operator== (const FileStamp& stamp) const { return size == stamp.size && mtime == stamp.mtime; }
+        bool operator!= (const FileStamp& stamp) const { return !(*this == stamp); }
+    };
+
+    /**
+     * @return Stamp of file or nullopt if file doesn't exist
+     */
+    inline auto fileStamp(StrViewCref path) -> std::optional<FileStamp> {
+        auto stamp = FileStamp();
+
+        if (scm_fs_dtls::_fileStamp(path, stamp.size, stamp.mtime))
+            return stamp;
+        return {};
+    }
+
+    struct FileTask;
+    using FileFuture = std::shared_future<std::shared_ptr<FileTask>>;
+
+    /**
+     * Loaded and tokenized file. Includes are loaded concurrently
+     * and merged in order of include directives
+     */
+    struct FileTask {
+        // Stamp is taken before reading, so changes during parse make the cache stale
+        explicit FileTask(StrViewCref filePath, bool mapped = true):
+            path(filePath), stamp(fileStamp(path).value_or(FileStamp())), file(path, mapped) {}
+
+        String                   path;
+        FileStamp                stamp;
+        SCM_NAMESPACE::file_view file;
+        TokenVector              tokens;
+        ScmVector<ScmPair<SizeT, std::weak_ptr<FileFuture>>> includes; // token index, file owned by FileLoads
+        bool                     merging = false; // Tokens are being merged, including the file again is recursive
+    };
+
+    /**
+     * Files loaded by one parse. File included several times is loaded once,
+     * all its include directives share one future
+     */
+    struct FileLoads {
+        FileLoads(TaskPool& taskPool, bool mappedFiles): pool(taskPool), mapped(mappedFiles) {}
+
+        TaskPool&                                     pool;
+        bool                                          mapped;
+        std::map<String, std::shared_ptr<FileFuture>> files;
+#ifndef SCM_NO_THREADS
+        std::mutex                                    mutex;
+#endif
+    };
+
+    auto loadFileTask(const std::shared_ptr<FileLoads>& loads, StrViewCref path) -> std::shared_ptr<FileTask>;
+
+    ////////////////////////////////// Arena ///////////////////////////////////
+
+    /**
+     * Bump allocator for config strings
+     * Strings are copied to big blocks and released all at once
+     */
+    class StringArena {
+    public:
+        static constexpr SizeT BLOCK_SIZE = 64 * 1024;
+
+        StringArena() = default;
+
+        /**
+         * Copy shares stored strings with the source. Both continue to store strings
+         * in free tail of the last block, it's reserved atomically
+         */
+        StringArena(const StringArena& other): _blocks(other._blocks), _cur(other._cur) {}
+
+        StringArena& operator= (const StringArena&) = delete;
+
+        /**
+         * Copy string to arena
+         * @param str - string to be stored
+         * @return View of stored string, valid until clear()
+         */
+        auto store(StrViewCref str) -> StrView {
+            if (str.empty())
+                return {};
+
+            auto size = str.size();
+
+            // Big strings get own blocks, current block stays in use
+            if (size > BLOCK_SIZE / 4) {
+                _blocks.emplace_back(std::make_shared<Block>(size, size));
+                std::copy(str.begin(), str.end(), _blocks.back()->data.get());
+
+                return StrView(_blocks.back()->data.get(), size);
+            }
+
+            auto used = _cur ? _cur->used.load(std::memory_order_relaxed) : BLOCK_SIZE;
+
+            while (used + size <= BLOCK_SIZE &&
+                   !_cur->used.compare_exchange_weak(used, used + size, std::memory_order_relaxed)) {}
+
+            if (used + size > BLOCK_SIZE) {
+                _blocks.emplace_back(std::make_shared<Block>(BLOCK_SIZE, size));
+                _cur = _blocks.back().get();
+                used = 0;
+            }
+
+            auto data = _cur->data.get() + used;
+            std::copy(str.begin(), str.end(), data);
+
+            return StrView(data, size);
+        }
+
+        void clear() {
+            _blocks.clear();
+            _cur = nullptr;
+        }
+
+    private:
+        struct Block {
+            Block(SizeT size, SizeT reserved): data(new ScmChar8[size]), used(reserved) {}
+
+            std::unique_ptr<ScmChar8[]> data;
+            std::atomic<SizeT>          used; // Reserved bytes, copies of arena may share the block
+        };
+
+        ScmVector<std::shared_ptr<Block>> _blocks;
+        Block*                            _cur = nullptr; // Block for small strings
+    };
+
+    /**
+     * Set of strings stored in arena. Used for names, which repeat in many sections: every distinct name is stored once
+     * Open addressing with linear probing, empty slot is a view without data
+     */
+    class StringPool {
+    public:
+        /**
+         * Find stored copy of string, copy string to arena if it isn't stored yet
+         * @return View of stored string, valid until arena is cleared
+         */
+        auto intern(StrViewCref str, StringArena& arena) -> StrView {
+            if (str.empty())
+                return {};
+
+            if ((_size + 1) * 4 > _slots.size() * 3)
+                grow();
+
+            auto& slot = find(str);
+
+            if (!slot.data()) {
+                slot = arena.store(str);
+                ++_size;
+            }
+
+            return slot;
+        }
+
+        void clear() {
+            _slots = ScmVector<StrView>();
+            _size  = 0;
+        }
+
+    private:
+        auto find(StrViewCref str) -> StrView& {
+            auto mask = _slots.size() - 1;
+            auto i    = std::hash<StrView>()(str) & mask;
+
+            while (_slots[i].data() && _slots[i] != str)
+                i = (i + 1) & mask;
+
+            return _slots[i];
+        }
+
+        void grow() {
+            auto old = std::move(_slots);
+            _slots.assign(std::max(old.size() * 2, SizeT(64)), StrView());
+
+            for (auto& str : old)
+                if (str.data())
+                    find(str) = str;
+        }
+
+        ScmVector<StrView> _slots;
+        SizeT              _size = 0;
+    };
+
+
+    /////////////////////////////////// Value //////////////////////////////////
+
+    enum class ValueType : unsigned char {
+        None,   // Not classified
+        String,
+        Int,
+        Float,
+        Bool,
+        List,
+        Pending // Interpolation which isn't resolved yet, payload is its index. Exists only while parsing
+    };
+
+    /**
+     * Value string with optional scalar, classified at load time (see Value::preparse)
+     */
+    class Value {
+    public:
+        Value() = default;
+        Value(StrView text): _text(text) {}
+
+        /**
+         * Restore classified value (see payload())
+         */
+        Value(StrView text, ValueType type, std::uint64_t payload, float real32):
+            _text(text), _type(type), _real32(real32) { std::memcpy(&_integer, &payload, sizeof(payload)); }
+
+        operator StrViewCref() const { return _text; }
+
+        auto text    () const -> StrViewCref     { return _text; }
+        auto type    () const -> ValueType       { return _type; }
+        auto integer () const -> std::int64_t    { return _integer; }
+        auto real    () const -> double          { return _real; }
+        auto real32  () const -> float           { return _real32; }
+        auto boolean () const -> bool            { return _integer != 0; }
+
+        /**
+         * @return Raw bits of stored scalar (integer or double)
+         */
+        auto payload () const -> std::uint64_t {
+            std::uint64_t res;
+            std::memcpy(&res, &_integer, sizeof(res));
+            return res;
+        }
+
+        /**
+         * Classify text as int, float, bool, list or string and store scalar value
+         * Only values which are read with the same result as from text are stored
+         */
+        void preparse();
+
+    private:
+        StrView   _text;
+        ValueType _type   = ValueType::None;
+        float     _real32 = 0;
+        union {
+            std::int64_t _integer = 0;
+            double       _real;
+        };
+    };
+
+
+    ////////////////////////////////// Section /////////////////////////////////
+
+    /**
+     * Config section. Names and values are views to strings stored in CfgData arena
+     */
+    class Section {
+    public:
+        auto getValue(StrViewCref key) const -> const Value& {
             auto val = _pairs.find(key);
 
             SCM_EXCEPTION(CfgException, val != _pairs.end(), "Can't find key '", key, "' in section [", _name, "]");
@@ -51,42 +483,498 @@ namespace scm_details {
             return val->second;
         }
 
-        auto value(StringCref key) -> StringRef {
-            return _pairs[key];
+        /**
+         * Find value by key
+         * @return Pointer to value or nullptr if key doesn't exist
+         */
+        auto find(StrViewCref key) const -> const Value* {
+            auto val = _pairs.find(key);
+            return val != _pairs.end() ? &val->second : nullptr;
         }
 
-        auto valueOpt(StringCref key) const -> std::optional<String>  {
-            auto val = _pairs.find(key);
-            if (val == _pairs.end())
-                return {};
+        auto valueOpt(StrViewCref key) const -> std::optional<StrView>  {
+            auto val = find(key);
+            if (val)
+                return val->text();
             else
-                return val->second;
+                return {};
         }
 
-        bool isExists  (StringCref key) const {
+        bool isExists  (StrViewCref key) const {
             return _pairs.find(key) != _pairs.end();
         }
 
-        void add       (StringCref key, StringCref value) { _pairs.emplace(key, value); }
-        void add       (StringCref key, StringRval value) { _pairs.emplace(key, value); }
-        void addParent (StringCref parent)                { _parents.push_back(parent); }
+        void add       (StrView key, Value value)   { _pairs.emplace(key, value); }
+        void remove    (StrViewCref key)            { _pairs.erase(key); }
+        void addParent (StrView parent)             { _parents.push_back(parent); }
 
-        auto getMap     () -> StrStrMap&             { return _pairs; }
-        auto getMap     () const -> const StrStrMap& { return _pairs; }
-        auto getParents () -> StrVector&             { return _parents; }
-        auto getParents () const -> const StrVector& { return _parents; }
+        auto getMap     () -> StrValueMap&               { return _pairs; }
+        auto getMap     () const -> const StrValueMap&   { return _pairs; }
+        auto getParents () -> StrViewVector&             { return _parents; }
+        auto getParents () const -> const StrViewVector& { return _parents; }
 
         auto& name()       { return _name; }
         auto& name() const { return _name; }
+        auto& file()       { return _file; }
+        auto& file() const { return _file; }
+
+        /**
+         * Ancestors in lookup order: each parent is followed by its own ancestors.
+         * Inherited values aren't copied to the section, lookups go through this chain (see CfgData::findValue)
+         */
+        auto chain() const -> const StrViewVector& { return _chain; }
+
+        /**
+         * Build ancestor chain. Parents must be linked already (see CfgData::linkParents)
+         */
+        void linkParents(const CfgData& data);
+
+        bool linked() const { return _linked; }
+
+        /**
+         * Copy inherited values to the section, so lookups of them don't follow the chain
+         */
+        void materialize(const CfgData& data);
+
+        void preparse() {
+            for (auto& pair : _pairs)
+                if (pair.second.type() == ValueType::None)
+                    pair.second.preparse();
+        }
+
+    private:
+        StrValueMap   _pairs;
+        StrViewVector _parents;
+        StrViewVector _chain;
+        StrView       _name;
+        StrView       _file;
+        bool          _linked = false;
+    };
+
+
+    //////////////////////////// Conversion Cache //////////////////////////////
+
+    /**
+     * Converted values keyed by (value slot, type). Used by read_cached
+     * Slot is address of value in the section map, so entries must be dropped
+     * every time config data changes
+     */
+    class ConvertCache {
+    public:
+        /**
+         * Get converted value, convert and store it on first access
+         * @tparam T - value type
+         * @param slot - address of the value in the section
+         * @param convert - conversion function, returns T
+         * @return reference to stored value, valid until clear()
+         */
+        template <typename T, typename F>
+        auto get(const Value* slot, F&& convert) -> const T& {
+#ifndef SCM_NO_THREADS
+            std::lock_guard lock(_mutex);
+#endif
+            auto& entry = _entries[Key{slot, std::type_index(typeid(T))}];
+
+            if (!entry)
+                entry = std::make_unique<TypedEntry<T>>(convert());
+
+            return static_cast<const TypedEntry<T>&>(*entry).value;
+        }
 
-        void reload();
+        void clear() {
+#ifndef SCM_NO_THREADS
+            std::lock_guard lock(_mutex);
+#endif
+            _entries.clear();
+        }
 
     private:
-        StrStrMap _pairs;
-        StrVector _parents;
-        String    _name;
-        String    _file;
-        bool      _alreadyReloaded = false;
+        struct Entry {
+            virtual ~Entry() = default;
+        };
+
+        template <typename T>
+        struct TypedEntry : Entry {
+            explicit TypedEntry(T val): value(std::move(val)) {}
+            T value;
+        };
+
+        using Key = std::pair<const Value*, std::type_index>;
+
+        struct KeyHash {
+            auto operator()(const Key& key) const -> SizeT {
+                return std::hash<const void*>()(key.first) ^ (key.second.hash_code() << 1);
+            }
+        };
+
+        std::unordered_map<Key, std::unique_ptr<Entry>, KeyHash> _entries;
+#ifndef SCM_NO_THREADS
+        std::mutex _mutex;
+#endif
+    };
+
+
+    ////////////////////////////// Dependencies //////////////////////////////
+
+    /**
+     * Part of config which is parsed as a whole: section, or global keys of one file
+     * first - file path, second - section name
+     * Unit with empty path and GLOBAL_NAMESPACE is the whole global namespace
+     */
+    using Unit = ScmPair<StrView, StrView>;
+
+    /**
+     * Order of units in the graph. Paths are long and often equal, so section names are compared first
+     */
+    struct UnitLess {
+        bool operator()(const Unit& a, const Unit& b) const {
+            auto cmp = a.second.compare(b.second);
+            return cmp != 0 ? cmp < 0 : a.first < b.first;
+        }
+    };
+
+    using UnitSet = std::set<Unit, UnitLess>;
+
+    /**
+     * Loaded config file
+     */
+    struct SourceFile {
+        StrView       path;
+        FileStamp     stamp;
+        StrViewVector directives; // Arguments of all directives, in order
+    };
+
+    /**
+     * Units of every file and dependencies between units through interpolation and inheritance
+     * Used by incremental reload to find units which must be parsed again
+     */
+    class DependencyGraph {
+    public:
+        void addUnit(const Unit& unit) {
+            _fileUnits[unit.first].insert(unit.second);
+        }
+
+        /**
+         * @return Global keys of file, parser adds new keys to them
+         */
+        auto globalKeys(StrViewCref file) -> StrViewVector& {
+            addUnit(Unit(file, GLOBAL_NAMESPACE));
+            return _fileGlobalKeys[file];
+        }
+
+        /**
+         * Remember that unit uses values of another unit
+         */
+        void addDependency(const Unit& unit, const Unit& dependency) {
+            if (unit == dependency)
+                return;
+
+            _dependents[dependency].insert(unit);
+            _dependencies[unit].insert(dependency);
+        }
+
+        /**
+         * Remember many dependencies at once. Sorted dependencies are inserted next to each other,
+         * which is much faster for large configs than adding them one by one
+         * @param deps - pairs of unit and its dependency, order is changed
+         */
+        void addDependencies(ScmVector<ScmPair<Unit, Unit>>& deps) {
+            auto less = UnitLess();
+
+            std::sort(deps.begin(), deps.end(), [&](auto& a, auto& b) {
+                return less(a.first, b.first) || (!less(b.first, a.first) && less(a.second, b.second));
+            });
+
+            for (auto dep = deps.begin(); dep != deps.end();) {
+                auto& units = _dependencies[dep->first];
+
+                for (auto& unit = dep->first; dep != deps.end() && dep->first == unit; ++dep)
+                    if (dep->first != dep->second)
+                        units.insert(units.end(), dep->second);
+            }
+
+            std::sort(deps.begin(), deps.end(), [&](auto& a, auto& b) {
+                return less(a.second, b.second) || (!less(b.second, a.second) && less(a.first, b.first));
+            });
+
+            for (auto dep = deps.begin(); dep != deps.end();) {
+                auto& units = _dependents[dep->second];
+
+                for (auto& unit = dep->second; dep != deps.end() && dep->second == unit; ++dep)
+                    if (dep->first != dep->second)
+                        units.insert(units.end(), dep->first);
+            }
+        }
+
+        /**
+         * @return Units of files and all units which depend on them directly or through other units
+         */
+        auto affected(const StrViewVector& files) const -> std::set<Unit> {
+            auto result = std::set<Unit>();
+            auto queue  = ScmVector<Unit>();
+
+            for (auto& file : files) {
+                auto units = _fileUnits.find(file);
+                if (units != _fileUnits.end())
+                    for (auto& sect : units->second)
+                        queue.emplace_back(file, sect);
+            }
+
+            while (!queue.empty()) {
+                auto unit = queue.back();
+                queue.pop_back();
+
+                if (!result.insert(unit).second)
+                    continue;
+
+                // Global keys of all files are one namespace for $key references
+                if (unit.second == GLOBAL_NAMESPACE && !unit.first.empty())
+                    queue.emplace_back(StrView(), GLOBAL_NAMESPACE);
+
+                auto dependents = _dependents.find(unit);
+                if (dependents != _dependents.end())
+                    queue.insert(queue.end(), dependents->second.begin(), dependents->second.end());
+            }
+
+            return result;
+        }
+
+        auto units(StrViewCref file) const -> std::set<StrView> {
+            auto units = _fileUnits.find(file);
+            return units != _fileUnits.end() ? units->second : std::set<StrView>();
+        }
+
+        /**
+         * Forget unit and its own dependencies. Units which depend on it are kept
+         * @return Global keys of the unit if it is global
+         */
+        auto removeUnit(const Unit& unit) -> StrViewVector {
+            auto keys = StrViewVector();
+
+            auto dependencies = _dependencies.find(unit);
+            if (dependencies != _dependencies.end()) {
+                for (auto& dependency : dependencies->second)
+                    _dependents[dependency].erase(unit);
+                _dependencies.erase(dependencies);
+            }
+
+            auto units = _fileUnits.find(unit.first);
+            if (units != _fileUnits.end())
+                units->second.erase(unit.second);
+
+            if (unit.second == GLOBAL_NAMESPACE) {
+                auto fileKeys = _fileGlobalKeys.find(unit.first);
+                if (fileKeys != _fileGlobalKeys.end()) {
+                    keys = std::move(fileKeys->second);
+                    _fileGlobalKeys.erase(fileKeys);
+                }
+            }
+
+            return keys;
+        }
+
+        /**
+         * Graph is incomplete if data wasn't produced by the parser (loaded from compiled cache)
+         * or incremental reload failed
+         */
+        bool complete() const     { return _complete; }
+        void complete(bool value) { _complete = value; }
+
+        void clear() {
+            _fileUnits.clear();
+            _dependents.clear();
+            _dependencies.clear();
+            _fileGlobalKeys.clear();
+            _complete = true;
+        }
+
+    private:
+        std::map<StrView, std::set<StrView>> _fileUnits;
+        std::map<Unit, UnitSet, UnitLess>    _dependents;
+        std::map<Unit, UnitSet, UnitLess>    _dependencies;
+        std::map<StrView, StrViewVector>     _fileGlobalKeys;
+        bool                                 _complete = true;
+    };
+
+
+    ///////////////////////////////// Frozen Index ///////////////////////////////
+
+    /**
+     * Read-only index of own values of all sections by (section, key), built by CfgData::freeze
+     * Minimal perfect hash (hash and displace): keys are split into small buckets, and each bucket gets a seed
+     * which places all its keys into free slots. Lookup reads the bucket seed and one slot, no chains are followed.
+     * Values are copied into slots, so value and its names share one cache line
+     */
+    class FrozenIndex {
+    public:
+        explicit FrozenIndex(const StrSectionMap& sections) {
+            auto hashes = ScmVector<std::uint64_t>();
+            auto total  = SizeT(0);
+
+            for (auto& s : sections)
+                total += s.second->getMap().size();
+
+            hashes.reserve(total);
+            _slots.reserve(total);
+
+            for (auto& s : sections) {
+                auto sectHash = SCM_NAMESPACE::fnv1a(s.first);
+
+                for (auto& pair : s.second->getMap()) {
+                    hashes.push_back(SCM_NAMESPACE::hash_combine(sectHash, SCM_NAMESPACE::fnv1a(pair.first)));
+                    _slots.push_back(Slot{s.first, pair.first, pair.second});
+                }
+            }
+
+            SCM_EXCEPTION(CfgException, _slots.size() < DIRECT, "Too many values to freeze config");
+
+            if (_slots.empty())
+                return;
+
+            // Keys grouped by bucket, larger buckets are placed first while the table is empty
+            auto count   = _slots.size();
+            auto offsets = ScmVector<SizeT>(count / KEYS_PER_BUCKET + 2, 0);
+            auto keys    = ScmVector<SizeT>(count);
+
+            _seeds.assign(offsets.size() - 1, 0);
+
+            for (auto hash : hashes)
+                ++offsets[bucket(hash) + 1];
+
+            std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+            auto fill = offsets;
+            for (SizeT i = 0; i < count; ++i)
+                keys[fill[bucket(hashes[i])]++] = i;
+
+            auto buckets = ScmVector<SizeT>(_seeds.size());
+            std::iota(buckets.begin(), buckets.end(), SizeT(0));
+            std::stable_sort(buckets.begin(), buckets.end(), [&](auto a, auto b) {
+                return offsets[a + 1] - offsets[a] > offsets[b + 1] - offsets[b];
+            });
+
+            auto slots     = ScmVector<Slot>(count);
+            auto used      = ScmVector<bool>(count, false);
+            auto positions = ScmVector<SizeT>();
+            auto nextFree  = SizeT(0);
+
+            for (auto b : buckets) {
+                auto first = keys.begin() + offsets[b];
+                auto last  = keys.begin() + offsets[b + 1];
+
+                if (first == last)
+                    break;
+
+                // Single key doesn't need a seed, its slot is stored instead
+                if (last - first == 1) {
+                    while (used[nextFree])
+                        ++nextFree;
+
+                    _seeds[b]       = DIRECT | static_cast<std::uint32_t>(nextFree);
+                    used[nextFree]  = true;
+                    slots[nextFree] = _slots[*first];
+                    continue;
+                }
+
+                // No seed separates keys with equal hashes
+                for (auto a = first; a != last; ++a)
+                    for (auto other = a + 1; other != last; ++other)
+                        if (hashes[*a] == hashes[*other])
+                            SCM_EXCEPTION(CfgException, false, "Can't freeze config: [",
+                                          _slots[*a].section, "] ", _slots[*a].key, " and [", _slots[*other].section,
+                                          "] ", _slots[*other].key, " have equal hashes");
+
+                auto seed = std::uint32_t(1);
+
+                for (; seed < MAX_SEED; ++seed) {
+                    positions.clear();
+
+                    for (auto key = first; key != last; ++key) {
+                        auto pos = position(hashes[*key], seed);
+
+                        if (used[pos] || std::find(positions.begin(), positions.end(), pos) != positions.end())
+                            break;
+
+                        positions.push_back(pos);
+                    }
+
+                    if (positions.size() == static_cast<SizeT>(last - first))
+                        break;
+                }
+
+                SCM_EXCEPTION(CfgException, seed < MAX_SEED, "Can't freeze config: no seed places key [",
+                              _slots[*first].section, "] ", _slots[*first].key, " with ",
+                              std::to_string(last - first - 1).data(), " other keys of its bucket");
+
+                _seeds[b] = seed;
+
+                for (SizeT i = 0; i < positions.size(); ++i) {
+                    used[positions[i]]  = true;
+                    slots[positions[i]] = _slots[first[i]];
+                }
+            }
+
+            _slots = std::move(slots);
+        }
+
+        /**
+         * Find own value of section
+         * @param keyHash - fnv1a hash of key, the same for all sections
+         * @return Pointer to value or nullptr if section doesn't have the key
+         */
+        auto find(StrViewCref section, StrViewCref key, std::uint64_t keyHash) const -> const Value* {
+            return probe(section, key, SCM_NAMESPACE::hash_combine(SCM_NAMESPACE::fnv1a(section), keyHash));
+        }
+
+        /**
+         * Find own value of section by precomputed hash
+         * @param hash - hash_combine(fnv1a(section), fnv1a(key))
+         * @return Pointer to value or nullptr if section doesn't have the key
+         */
+        auto probe(StrViewCref section, StrViewCref key, std::uint64_t hash) const -> const Value* {
+            if (_slots.empty())
+                return nullptr;
+
+            auto  seed = _seeds[bucket(hash)];
+            auto& slot = _slots[seed & DIRECT ? seed & ~DIRECT : position(hash, seed)];
+
+            return slot.key == key && slot.section == section ? &slot.value : nullptr;
+        }
+
+    private:
+        static constexpr SizeT         KEYS_PER_BUCKET = 2;
+        static constexpr std::uint32_t DIRECT          = 1u << 31; // Seed holds slot index
+        static constexpr std::uint32_t MAX_SEED        = 1u << 20; // Seeds found on large configs are below 1000
+
+        struct alignas(64) Slot {
+            StrView section;
+            StrView key;
+            Value   value;
+        };
+
+        static auto mix(std::uint64_t hash) -> std::uint64_t {
+            hash ^= hash >> 33;
+            hash *= 0xff51afd7ed558ccdULL;
+            hash ^= hash >> 33;
+            hash *= 0xc4ceb9fe1a85ec53ULL;
+            return hash ^ (hash >> 33);
+        }
+
+        // Map high 32 bits of hash to [0, size) without division. Sizes are less than 2^32
+        static auto reduce(std::uint64_t hash, SizeT size) -> SizeT {
+            return static_cast<SizeT>(((hash >> 32) * size) >> 32);
+        }
+
+        auto bucket(std::uint64_t hash) const -> SizeT {
+            return reduce(mix(hash), _seeds.size());
+        }
+
+        auto position(std::uint64_t hash, std::uint32_t seed) const -> SizeT {
+            return reduce(mix(hash ^ (seed * 0x9e3779b97f4a7c15ULL)), _slots.size());
+        }
+
+        ScmVector<std::uint32_t> _seeds;
+        ScmVector<Slot>          _slots;
     };
 
 
@@ -94,133 +982,907 @@ namespace scm_details {
 
     class CfgData {
     public:
-        auto getSection(StringCref key) const  -> const Section& {
+        auto getSection(StrViewCref key) const  -> const Section& {
             auto sect = _sections.find(key);
 
             SCM_EXCEPTION(CfgException, sect != _sections.end(), "Can't find section [", key, "]");
 
-            return sect->second;
+            return *sect->second;
         }
 
-        auto getSection(StringCref key) -> Section& {
+        auto getSection(StrViewCref key) -> Section& {
             auto sect = _sections.find(key);
 
             SCM_EXCEPTION(CfgException, sect != _sections.end(), "Can't find section [", key, "]");
 
-            return sect->second;
+            return own(sect->second);
         }
 
-        auto section(StringCref key) -> Section& {
-            auto& sect = _sections[key];
+        auto section(StrViewCref key) -> Section& {
+            auto sect = _sections.find(key);
 
-            if (sect.name().empty())
-                sect.name() = key;
+            if (sect != _sections.end())
+                return own(sect->second);
 
-            return sect;
+            auto name = key == GLOBAL_NAMESPACE ? GLOBAL_NAMESPACE : intern(key);
+            auto& res = _sections[name];
+            res = std::make_shared<Section>();
+            res->name() = name;
+
+            return *res;
         }
 
-        auto sectionOpt(StringCref key) const -> std::optional<Section> {
+        /**
+         * Find section by name
+         * @return Pointer to section or nullptr if section doesn't exist
+         */
+        auto findSection(StrViewCref key) const -> const Section* {
             auto sect = _sections.find(key);
-            if (sect == _sections.end())
-                return {};
-            else
-                return sect->second;
+            return sect != _sections.end() ? sect->second.get() : nullptr;
+        }
+
+        auto findSection(StrViewCref key) -> Section* {
+            auto sect = _sections.find(key);
+            return sect != _sections.end() ? &own(sect->second) : nullptr;
         }
 
-        bool isSectionExists(StringCref key) const {
+        bool isSectionExists(StrViewCref key) const {
             return _sections.find(key) != _sections.end();
         }
 
-        auto addSection(StringCref path, SizeT lineNum, StringCref key) -> Section& {
+        auto getSections() const -> const StrSectionMap& {
+            return _sections;
+        }
+
+        /**
+         * @return true if nothing was parsed since start or last clear
+         */
+        bool empty() const {
+            auto global = findSection(GLOBAL_NAMESPACE);
+            return _roots.empty() && _sections.size() == (global ? 1 : 0) && (!global || global->getMap().empty());
+        }
+
+        /**
+         * Add new section
+         * @param path - path to file with section, must be stored in arena
+         * @param lineNum - line of section definition
+         * @param key - section name
+         * @return Reference to new section
+         */
+        auto addSection(StrViewCref path, SizeT lineNum, StrViewCref key) -> Section& {
             SCM_EXCEPTION(CfgException, !isSectionExists(key) || key == GLOBAL_NAMESPACE,
                           "Duplicate section [", key, "] in ", path, ":", std::to_string(lineNum + 1).data());
 
-            auto& sect = _sections[key];
-            sect.name() = key;
+            auto& sect = section(key);
+            sect.file() = path;
 
             return sect;
         }
 
-        auto getValue(StringCref sect, StringCref key) const -> StringCref {
-            return getSection(sect).getValue(key);
+        auto getValue(StrViewCref sect, StrViewCref key) const -> const Value& {
+            auto val = findValue(sect, key);
+
+            if (!val)
+                getSection(sect); // Throws if section doesn't exist
+
+            SCM_EXCEPTION(CfgException, val, "Can't find key '", key, "' in section [", sect, "]");
+
+            return *val;
+        }
+
+        /**
+         * Find value in section or in its ancestors (see Section::chain)
+         * @return Pointer to value or nullptr if key doesn't exist
+         */
+        auto findValue(const Section& sect, StrViewCref key) const -> const Value* {
+            if (_frozen)
+                return findFrozen(sect, key, SCM_NAMESPACE::fnv1a(key));
+
+            auto val = sect.find(key);
+
+            for (auto name = sect.chain().begin(); !val && name != sect.chain().end(); ++name) {
+                auto parent = _sections.find(*name);
+                if (parent != _sections.end())
+                    val = parent->second->find(key);
+            }
+
+            return val;
         }
 
-        auto getValue(StringCref sect, StringCref key) -> StringRef {
-            return getSection(sect).getValue(key);
+        /**
+         * Find value by section and key
+         * @return Pointer to value or nullptr if section or key doesn't exist
+         */
+        auto findValue(StrViewCref section, StrViewCref key) const -> const Value* {
+            // Own values of frozen data are found without looking up the section
+            if (_frozen) {
+                auto keyHash = SCM_NAMESPACE::fnv1a(key);
+                if (auto val = _frozen->find(section, key, keyHash))
+                    return val;
+
+                auto sect = findSection(section);
+                return sect ? findFrozenInherited(*sect, key, keyHash) : nullptr;
+            }
+
+            auto sect = findSection(section);
+            return sect ? findValue(*sect, key) : nullptr;
         }
 
-        auto value(StringCref sect, StringCref key) -> StringRef {
-            return section(sect).value(key);
+        /**
+         * Find value by section and key with precomputed hashes (see key_handle).
+         * Hashes are used by lookups in frozen data, maps of other data hash the key themselves
+         * @param keyHash - fnv1a(key)
+         * @param hash - hash_combine(fnv1a(section), keyHash)
+         * @return Pointer to value or nullptr if section or key doesn't exist
+         */
+        auto findValue(StrViewCref section, StrViewCref key, std::uint64_t keyHash, std::uint64_t hash) const
+        -> const Value* {
+            if (!_frozen)
+                return findValue(section, key);
+
+            if (auto val = _frozen->probe(section, key, hash))
+                return val;
+
+            auto sect = findSection(section);
+            return sect ? findFrozenInherited(*sect, key, keyHash) : nullptr;
         }
 
-        auto valueOpt(StringCref section, StringCref key) const -> std::optional<String> {
-            auto res1 = sectionOpt(section);
-            if (res1)
-                return res1->valueOpt(key);
+        auto valueOpt(StrViewCref section, StrViewCref key) const -> std::optional<StrView> {
+            auto val = findValue(section, key);
+            if (val)
+                return val->text();
             return {};
         }
 
-        bool isValueExists(StringCref sect, StringCref key) const {
-            auto res1 = isSectionExists(sect);
-            if (res1)
-                return getSection(sect).isExists(key);
-            return false;
+        bool isValueExists(StrViewCref sect, StrViewCref key) const {
+            return findValue(sect, key) != nullptr;
+        }
+
+        /**
+         * Copy key and value to arena and add them to the section
+         */
+        void addValue(Section& sect, StrViewCref key, StrViewCref value) {
+            sect.add(intern(key), store(value));
+        }
+
+        void addValue(StrViewCref sect, StrViewCref key, StrViewCref value) {
+            addValue(section(sect), key, value);
+        }
+
+        /**
+         * Copy string to arena
+         * @return View of stored string, valid until clear()
+         */
+        auto store(StrViewCref str) -> StrView {
+            return _arena.store(str);
+        }
+
+        /**
+         * Copy string to arena once. All equal strings passed to intern share one copy.
+         * Used for names, values are mostly distinct and are stored with store()
+         * @return View of stored string, valid until clear()
+         */
+        auto intern(StrViewCref str) -> StrView {
+            return _pool.intern(str, _arena);
         }
 
-        void addValue(StringCref sect, StringCref key, StringCref value) {
-            section(sect).add(key, value);
+        /**
+         * Preparse all values which weren't classified yet. Sections are processed in parallel
+         */
+        void preparseValues(TaskPool& pool) {
+            constexpr SizeT valuesPerTask = 4096;
+
+            auto tasks  = ScmVector<std::future<void>>();
+            auto chunk  = ScmVector<Section*>();
+            auto values = SizeT(0);
+
+            auto submit = [&] {
+                tasks.push_back(pool.submit([chunk] {
+                    for (auto sect : chunk)
+                        sect->preparse();
+                }));
+                chunk.clear();
+                values = 0;
+            };
+
+            for (auto& s : _sections) {
+                chunk.push_back(&own(s.second));
+                values += s.second->getMap().size();
+
+                if (values >= valuesPerTask)
+                    submit();
+            }
+
+            if (!chunk.empty())
+                submit();
+
+            for (auto& task : tasks)
+                task.get();
+        }
+
+        /**
+         * Remember config file passed to parse
+         */
+        void addRoot(StrViewCref path) {
+            _roots.push_back(store(path));
+        }
+
+        auto roots() const -> const StrViewVector& {
+            return _roots;
+        }
+
+        /**
+         * Remember loaded file. Strings must be stored in arena
+         */
+        void addSource(SourceFile source) {
+            _sources.push_back(std::move(source));
+        }
+
+        auto sources() -> ScmVector<SourceFile>& {
+            return _sources;
+        }
+
+        auto sources() const -> const ScmVector<SourceFile>& {
+            return _sources;
+        }
+
+        auto graph() const -> const DependencyGraph& {
+            return *_graph;
         }
-        void addValue(StringCref sect, StringCref key, StringRval value) {
-            section(sect).add(key, value);
+
+        /**
+         * Graph is shared with copies of data (see clone), so it is copied before it is changed
+         */
+        auto graph() -> DependencyGraph& {
+            if (_graph.use_count() > 1)
+                _graph = std::make_shared<DependencyGraph>(*_graph);
+
+            return *_graph;
+        }
+
+        /**
+         * Remove section or global keys of a file, see Unit
+         */
+        void removeUnit(const Unit& unit) {
+            auto keys = graph().removeUnit(unit);
+
+            if (unit.second != GLOBAL_NAMESPACE) {
+                _sections.erase(unit.second);
+                return;
+            }
+
+            auto global = _sections.find(GLOBAL_NAMESPACE);
+            if (global != _sections.end())
+                for (auto& key : keys)
+                    own(global->second).remove(key);
         }
 
-        void reloadParents() {
-            for (auto& s : _sections)
-                s.second.reload();
+        /**
+         * Values which wait for resolution of references (see resolveReferences)
+         */
+        auto interpolations() -> Interpolations& {
+            return _interpolations;
+        }
+
+        /**
+         * True if all values were classified by preparse
+         */
+        bool preparsed() const      { return _preparsed; }
+        void preparsed(bool value)  { _preparsed = value; }
+
+        /**
+         * Size of text parsed again by incremental reloads. Old strings of that text stay in arena until clear()
+         */
+        auto reparsedSize() const -> SizeT { return _reparsedSize; }
+        void addReparsedSize(SizeT size)   { _reparsedSize += size; }
+
+        /**
+         * Keep mapped file alive until clear(). Used for data loaded from compiled cache
+         */
+        void keepFile(std::unique_ptr<SCM_NAMESPACE::file_view> file) {
+            _files.push_back(std::move(file));
+        }
+
+        /**
+         * Link parents of all sections which aren't linked yet and register dependencies on parents.
+         * Inheritance DAG of these sections is sorted topologically, sections of each level are linked in parallel
+         */
+        void linkParents(TaskPool& pool) {
+            constexpr SizeT sectionsPerTask = 1024;
+
+            // Section waits for its unlinked parents. Edges are (parent, child index)
+            auto nodes   = ScmVector<Section*>();
+            auto pending = ScmVector<SizeT>();
+            auto edges   = ScmVector<ScmPair<const Section*, SizeT>>();
+            auto level   = ScmVector<SizeT>();
+            auto deps    = ScmVector<ScmPair<Unit, Unit>>();
+
+            for (auto& s : _sections) {
+                if (s.second->linked())
+                    continue;
+
+                auto sect = &own(s.second);
+                auto wait = SizeT(0);
+
+                for (auto& name : sect->getParents()) {
+                    auto parent = _sections.find(name);
+
+                    SCM_EXCEPTION(CfgException, parent != _sections.end(),
+                                  "Can't find parent section [", name, "] of section [", sect->name(), "] in ", sect->file());
+
+                    deps.emplace_back(Unit(sect->file(), sect->name()), Unit(parent->second->file(), parent->first));
+
+                    if (!parent->second->linked()) {
+                        edges.emplace_back(&own(parent->second), nodes.size());
+                        ++wait;
+                    }
+                }
+
+                if (wait == 0)
+                    level.push_back(nodes.size());
+
+                nodes.push_back(sect);
+                pending.push_back(wait);
+            }
+
+            graph().addDependencies(deps);
+
+            auto less = [](const auto& edge, const Section* sect) { return std::less<const Section*>()(edge.first, sect); };
+            std::sort(edges.begin(), edges.end(), [&](const auto& a, const auto& b) { return less(a, b.first); });
+
+            while (!level.empty()) {
+                auto tasks = ScmVector<std::future<void>>();
+
+                for (SizeT first = 0; first < level.size(); first += sectionsPerTask) {
+                    auto last = std::min(first + sectionsPerTask, level.size());
+                    auto link = [this, &nodes, &level, first, last] {
+                        for (auto j = first; j < last; ++j)
+                            nodes[level[j]]->linkParents(*this);
+                    };
+
+                    // Small levels don't start the pool
+                    if (first == 0 && last == level.size())
+                        link();
+                    else
+                        tasks.push_back(pool.submit(link));
+                }
+
+                for (auto& task : tasks)
+                    task.wait();
+                for (auto& task : tasks)
+                    task.get();
+
+                auto next = ScmVector<SizeT>();
+
+                for (auto i : level) {
+                    auto edge = std::lower_bound(edges.begin(), edges.end(), nodes[i], less);
+
+                    for (; edge != edges.end() && edge->first == nodes[i]; ++edge)
+                        if (--pending[edge->second] == 0)
+                            next.push_back(edge->second);
+                }
+
+                level = std::move(next);
+            }
+
+            auto unlinked = std::find_if(nodes.begin(), nodes.end(), [](auto sect) { return !sect->linked(); });
+
+            if (unlinked != nodes.end())
+                SCM_EXCEPTION(CfgException, false, "Inheritance cycle ", inheritanceCycle(*unlinked));
+        }
+
+        /**
+         * Store inherited values in the section itself. It stays materialized after it is parsed again
+         * and in data made by cloneEmpty
+         */
+        void materialize(StrViewCref section) {
+            if (!isMaterialized(section))
+                _materialized.push_back(intern(section)); // Same view as the section name, no new copy
+
+            auto sect = findSection(section);
+            if (sect && sect->linked())
+                sect->materialize(*this);
+        }
+
+        bool isMaterialized(StrViewCref section) const {
+            return std::find(_materialized.begin(), _materialized.end(), section) != _materialized.end();
+        }
+
+        /**
+         * Build perfect hash index of all values (see FrozenIndex). Values are read from the index after that,
+         * sections are used only to follow inheritance chains. Data must not be changed until thaw()
+         */
+        void freeze() {
+            _frozen = std::make_shared<FrozenIndex>(_sections);
+        }
+
+        /**
+         * Drop frozen index, lookups use sections again
+         */
+        void thaw() {
+            _frozen.reset();
+        }
+
+        bool frozen() const {
+            return _frozen != nullptr;
         }
 
         void clear() {
             _sections.clear();
+            _roots.clear();
+            _sources.clear();
+            _files.clear();
+            _materialized.clear();
+            _frozen.reset();
+            _interpolations = Interpolations();
+            _graph          = std::make_shared<DependencyGraph>();
+            _preparsed      = false;
+            _reparsedSize   = 0;
+            _arena.clear();
+            _pool.clear();
+            nextGeneration();
+        }
+
+        /**
+         * Generation of data. Changes after every parse and clear,
+         * pointers to values from previous generations may be invalid
+         */
+        auto generation() const -> SizeT {
+            return _generation;
+        }
+
+        void nextGeneration() {
+            _generation = newGeneration();
+            _cache.clear();
+        }
+
+        auto cache() const -> ConvertCache& {
+            return _cache;
         }
 
     private:
-        StrSectionMap _sections;
+        StrSectionMap        _sections;
+        StrViewVector        _roots;
+        StrViewVector        _materialized;
+        StringArena          _arena;
+        StringPool           _pool;
+
+        std::shared_ptr<const FrozenIndex>                     _frozen; // Shared with copies
+
+        ScmVector<SourceFile>                                  _sources;
+        ScmVector<std::shared_ptr<SCM_NAMESPACE::file_view>>   _files;
+        std::shared_ptr<DependencyGraph>                       _graph = std::make_shared<DependencyGraph>(); // Shared with copies
+        Interpolations                                         _interpolations;
+        bool                                                   _preparsed    = false;
+        SizeT                                                  _reparsedSize = 0;
+
+        SizeT                _generation = newGeneration();
+        mutable ConvertCache _cache;
+
+        // Generations are unique among all instances, so a value cached for one instance is never taken from another
+        static auto newGeneration() -> SizeT {
+            static std::atomic<SizeT> counter{0};
+            return ++counter;
+        }
+
+        /**
+         * Sections are shared with copies of data (see clone), so section is copied before it is changed
+         */
+        static auto own(std::shared_ptr<Section>& sect) -> Section& {
+            if (sect.use_count() > 1)
+                sect = std::make_shared<Section>(*sect);
+            else
+                std::atomic_thread_fence(std::memory_order_acquire); // Other owner may have just released it
+
+            return *sect;
+        }
+
+        /**
+         * findValue on frozen data. Inherited values are looked up in the index too, one probe per ancestor
+         */
+        auto findFrozen(const Section& sect, StrViewCref key, std::uint64_t keyHash) const -> const Value* {
+            auto val = _frozen->find(sect.name(), key, keyHash);
+            return val ? val : findFrozenInherited(sect, key, keyHash);
+        }
+
+        auto findFrozenInherited(const Section& sect, StrViewCref key, std::uint64_t keyHash) const -> const Value* {
+            auto val = static_cast<const Value*>(nullptr);
+
+            for (auto name = sect.chain().begin(); !val && name != sect.chain().end(); ++name)
+                val = _frozen->find(*name, key, keyHash);
+
+            return val;
+        }
+
+        /**
+         * Every section which is left unlinked by linkParents has unlinked parent, so following them leads to a cycle
+         * @param sect - unlinked section
+         * @return Cycle description
+         */
+        auto inheritanceCycle(const Section* sect) const -> String {
+            auto path = ScmVector<const Section*>();
+
+            while (std::find(path.begin(), path.end(), sect) == path.end()) {
+                path.push_back(sect);
+
+                for (auto& name : sect->getParents()) {
+                    auto parent = findSection(name);
+                    if (!parent->linked()) {
+                        sect = parent;
+                        break;
+                    }
+                }
+            }
+
+            auto cycle = String();
+            for (auto i = std::find(path.begin(), path.end(), sect); i != path.end(); ++i)
+                cycle += SCM_NAMESPACE::str_join("[", (*i)->name(), "] -> ");
+
+            return SCM_NAMESPACE::str_join(cycle, "[", sect->name(), "] in ", sect->file());
+        }
+
+        // Converted values and generation aren't copied, copy is new data
+        // String pool isn't copied too, strings stored after copy are interned among themselves
+        CfgData(const CfgData& other):
+            _sections(other._sections), _roots(other._roots), _materialized(other._materialized),
+            _arena(other._arena), _frozen(other._frozen), _sources(other._sources),
+            _files(other._files), _graph(other._graph), _preparsed(other._preparsed),
+            _reparsedSize(other._reparsedSize) {}
 
-        // Singleton impl
     public:
-        CfgData(const CfgData&) = delete;
+        CfgData() { addSection("", 0, GLOBAL_NAMESPACE); }
+
         CfgData& operator= (const CfgData&) = delete;
 
-        static CfgData& instance() {
-            static CfgData inst;
-            return inst;
+        /**
+         * Copy data to change it while this one is still read. Strings, mapped files, sections and dependency graph
+         * are shared, section and graph are copied when they are changed
+         */
+        auto clone() const -> std::unique_ptr<CfgData> {
+            return std::unique_ptr<CfgData>(new CfgData(*this));
         }
 
+        /**
+         * New empty data for parsing from scratch. Only materialized sections are kept
+         */
+        auto cloneEmpty() const -> std::unique_ptr<CfgData> {
+            auto data = std::make_unique<CfgData>();
+
+            for (auto& name : _materialized)
+                data->materialize(name);
+
+            return data;
+        }
+    };
+
+
+    ////////////////////////////// Published Data //////////////////////////////
+
+    /**
+     * Epoch based reclamation of replaced config data
+     * Reader announces global epoch before it takes data and resets it after reads, so reads never wait.
+     * Writer replaces data, retires old one with current epoch and advances the epoch.
+     * Retired data is freed when every reader is idle or has announced a later epoch
+     */
+    class Epochs {
+    public:
+        static auto instance() -> Epochs& {
+            static Epochs epochs;
+            return epochs;
+        }
+
+        /**
+         * Announce current epoch for the calling thread. Pins may be nested
+         */
+        void pin() {
+            auto& record = local();
+
+            if (record.depth++ == 0)
+                record.epoch.store(_epoch.load());
+        }
+
+        void unpin() {
+            auto& record = local();
+
+            if (--record.depth == 0)
+                record.epoch.store(IDLE, std::memory_order_release);
+        }
+
+        /**
+         * Pins epoch for the scope
+         */
+        struct Pin {
+            Pin()  { instance().pin(); }
+            ~Pin() { instance().unpin(); }
+
+            Pin(const Pin&) = delete;
+            Pin& operator= (const Pin&) = delete;
+        };
+
+        /**
+         * Free data when no reader can use it. Data must be already replaced, so new readers can't take it
+         */
+        void retire(std::unique_ptr<CfgData> data) {
+#ifndef SCM_NO_THREADS
+            std::lock_guard lock(_mutex);
+#endif
+            _retired.emplace_back(_epoch.fetch_add(1), std::move(data));
+            reclaimRetired();
+        }
+
+        /**
+         * Free retired data which isn't read anymore
+         */
+        void reclaim() {
+#ifndef SCM_NO_THREADS
+            std::lock_guard lock(_mutex);
+#endif
+            reclaimRetired();
+        }
+
+        ~Epochs() {
+            for (auto record = _records.load(); record;)
+                delete std::exchange(record, record->next);
+        }
+
+        Epochs(const Epochs&) = delete;
+        Epochs& operator= (const Epochs&) = delete;
+
     private:
-        CfgData() { addSection("", 0, "__global"); }
-        ~CfgData() = default;
+        Epochs() = default;
+
+        static constexpr SizeT IDLE = SizeT(-1);
+
+        struct Record {
+            std::atomic<SizeT> epoch = IDLE;
+            std::atomic<bool>  used  = true;
+            SizeT              depth = 0;       // Accessed only by the owner thread
+            Record*            next  = nullptr; // Immutable after record is added
+        };
+
+        /**
+         * Record of the calling thread. Records are freed only with Epochs, record of finished thread is reused
+         */
+        static auto local() -> Record& {
+            static thread_local Record* record = nullptr;
+
+            if (!record)
+                record = registerThread();
+
+            return *record;
+        }
+
+        static auto registerThread() -> Record* {
+            struct Owner {
+                Record* record;
+                ~Owner() { record->used.store(false, std::memory_order_release); }
+            };
+
+            static thread_local Owner owner{instance().acquire()};
+            return owner.record;
+        }
+
+        auto acquire() -> Record* {
+            for (auto record = _records.load(); record; record = record->next) {
+                bool used = false;
+
+                if (record->used.compare_exchange_strong(used, true))
+                    return record;
+            }
+
+            auto record = new Record;
+            record->next = _records.load();
+
+            while (!_records.compare_exchange_weak(record->next, record)) {}
+
+            return record;
+        }
+
+        void reclaimRetired() {
+            auto oldest = IDLE;
+
+            for (auto record = _records.load(); record; record = record->next)
+                oldest = std::min(oldest, record->epoch.load());
+
+            // Readers which announced epoch of retirement or earlier may still use the data
+            auto end = std::remove_if(_retired.begin(), _retired.end(), [&](auto& r) { return r.first < oldest; });
+            _retired.erase(end, _retired.end());
+        }
+
+        std::atomic<SizeT>                                   _epoch   = 0;
+        std::atomic<Record*>                                 _records = nullptr;
+        ScmVector<ScmPair<SizeT, std::unique_ptr<CfgData>>>  _retired;
+#ifndef SCM_NO_THREADS
+        std::mutex                                           _mutex;
+#endif
     };
 
-    inline CfgData& cfg_data() { return CfgData::instance(); }
+    /**
+     * Config data of one config instance. Writers prepare new data aside and publish it with atomic pointer swap,
+     * so readers never wait and never see partially parsed data. Readers take data with ReadGuard.
+     * Writers take WriteGuard before they copy current data, so concurrent updates aren't lost
+     */
+    class CfgDataSlot {
+    public:
+        // Epochs must outlive slots with static storage, because their data is retired there
+        CfgDataSlot(): _current(new CfgData) { Epochs::instance(); }
+
+        /**
+         * Current data. Only writers may use it without ReadGuard, replaced data is freed after publish
+         */
+        auto get() const -> CfgData& {
+            return *_current.load();
+        }
 
+        /**
+         * Replace current data. Old data is freed when all readers are finished with it
+         */
+        void publish(std::unique_ptr<CfgData> data) {
+            auto old = _current.exchange(data.release());
+            Epochs::instance().retire(std::unique_ptr<CfgData>(old));
+        }
 
+        ~CfgDataSlot() {
+            delete _current.load();
+        }
 
-    inline void Section::reload() {
-        for (const auto& sectStr : _parents) {
-            auto& sect = cfg_data().getSection(sectStr);
+        CfgDataSlot(const CfgDataSlot&) = delete;
+        CfgDataSlot& operator= (const CfgDataSlot&) = delete;
 
-            if (!sect._alreadyReloaded && !sect.getParents().empty())
-                sect.reload();
+    private:
+        friend class WriteGuard;
 
-            auto pairs = sect.getMap();
+        std::atomic<CfgData*> _current;
+#ifndef SCM_NO_THREADS
+        std::mutex            _writeMutex;
+#endif
+    };
 
-            for (const auto& pair : pairs) {
-                if (!isExists(pair.first))
-                    add(pair.first, pair.second);
+    /**
+     * Serializes writers of the slot from taking current data until the new data is published.
+     * Otherwise writer which copied data before publish of another writer would drop its changes
+     */
+    class WriteGuard {
+    public:
+#ifndef SCM_NO_THREADS
+        explicit WriteGuard(CfgDataSlot& slot): _lock(slot._writeMutex) {}
+#else
+        explicit WriteGuard(CfgDataSlot&) {}
+        ~WriteGuard() {} // Not trivial, so unused guard variables aren't reported
+#endif
+
+        WriteGuard(const WriteGuard&) = delete;
+        WriteGuard& operator= (const WriteGuard&) = delete;
+
+    private:
+#ifndef SCM_NO_THREADS
+        std::lock_guard<std::mutex> _lock;
+#endif
+    };
+
+    /**
+     * Pins current data of the slot for the calling thread. Nested guards of the same slot
+     * get the same data, so all reads under the outer guard see one version of config
+     */
+    class ReadGuard {
+    public:
+        explicit ReadGuard(const CfgDataSlot& slot): _slot(&slot) {
+            auto& local = pinned();
+
+            for (SizeT i = 0; i < local.size; ++i) {
+                if (local.items[i].slot == _slot) {
+                    ++local.items[i].depth;
+                    _data       = local.items[i].data;
+                    _registered = true;
+                    return;
+                }
+            }
+
+            // Epoch must be announced before data is taken
+            Epochs::instance().pin();
+            _data = &slot.get();
+
+            // Too many slots pinned at once: data is still safe to read, but isn't shared with nested guards
+            if (local.size < MAX_PINNED) {
+                local.items[local.size++] = Pinned{_slot, _data, 1};
+                _registered = true;
+            }
+        }
+
+        ~ReadGuard() {
+            if (_registered) {
+                auto& local = pinned();
+                auto  item  = std::find_if(local.items, local.items + local.size, [&](auto& p) { return p.slot == _slot; });
+
+                if (--item->depth != 0)
+                    return;
+
+                *item = local.items[--local.size];
+            }
+
+            Epochs::instance().unpin();
+        }
+
+        ReadGuard(const ReadGuard&) = delete;
+        ReadGuard& operator= (const ReadGuard&) = delete;
+
+        auto data() const -> const CfgData& {
+            return *_data;
+        }
+
+    private:
+        static constexpr SizeT MAX_PINNED = 8;
+
+        struct Pinned {
+            const CfgDataSlot* slot;
+            const CfgData*     data;
+            SizeT              depth;
+        };
+
+        struct Local {
+            Pinned items[MAX_PINNED];
+            SizeT  size;
+        };
+
+        static auto pinned() -> Local& {
+            static thread_local Local local{};
+            return local;
+        }
+
+        const CfgDataSlot* _slot;
+        const CfgData*     _data;
+        bool               _registered = false;
+    };
+
+    /**
+     * Current data of the default config for single threaded code and writers. Defined in scm.hpp
+     */
+    CfgData& cfg_data();
+
+
+
+    inline void Section::linkParents(const CfgData& data) {
+        _chain.clear();
+
+        if (_parents.size() == 1) {
+            auto& parent = data.getSection(_parents.front());
+
+            _chain.reserve(parent._chain.size() + 1);
+            _chain.push_back(parent.name());
+            _chain.insert(_chain.end(), parent._chain.begin(), parent._chain.end());
+        }
+        else {
+            // Section reached through several parents is checked only at its first position
+            auto add = [&](StrViewCref name) {
+                if (std::find(_chain.begin(), _chain.end(), name) == _chain.end())
+                    _chain.push_back(name);
+            };
+
+            for (const auto& sectStr : _parents) {
+                auto& parent = data.getSection(sectStr);
+
+                add(parent.name());
+                for (auto& name : parent._chain)
+                    add(name);
             }
         }
 
-        _alreadyReloaded = true;
+        _linked = true;
+
+        if (data.isMaterialized(_name))
+            materialize(data);
+    }
+
+    inline void Section::materialize(const CfgData& data) {
+        for (auto& name : _chain) {
+            auto sect = data.findSection(name);
+            if (!sect)
+                continue;
+
+            for (const auto& pair : sect->getMap())
+                if (!isExists(pair.first))
+                    add(pair.first, pair.second);
+        }
     }
 
     // Numbers
@@ -250,6 +1912,41 @@ namespace scm_details {
         return false; // !?
     }
 
+    /**
+     * Unpack list of values from string without materializing it
+     * @param required - numbers of required values (0 if any number)
+     * @param callback - called with every element in order
+     * @return Number of elements
+     */
+    template <typename F>
+    auto unpackEach(StrViewCref name, StrViewCref section, StrViewCref str, SizeT required, F&& callback) -> SizeT {
+        SizeT pos   = 0;
+        SizeT count = 0;
+
+        if (!str.empty()) {
+            auto first = nextElement(name, section, str, pos);
+
+            // Whole value in braces: {a, b, c}
+            if (pos == str.size() && first.size() > 1 && first.front() == '{' && first.back() == '}')
+                return unpackEach(name, section, first.substr(1, first.size() - 2), required,
+                                  std::forward<F>(callback));
+
+            callback(first);
+            ++count;
+
+            while (pos != str.size()) {
+                callback(nextElement(name, section, str, pos));
+                ++count;
+            }
+        }
+
+        SCM_EXCEPTION(CfgException, required == 0 || required == count,
+                      "Wrong number of values at key '", name, "' in section [", section, "]. Provided ",
+                      std::to_string(count).data(), ", required ", std::to_string(required).data(), ".");
+
+        return count;
+    }
+
     //
     template <typename... Ts, SizeT... _Idx>
     auto readTupleImpl(StrViewVector& vec, StrViewCref name, StrViewCref section, std::index_sequence<_Idx...>) {
@@ -266,11 +1963,15 @@ namespace scm_details {
     }
 
     template <typename T>
-    auto readVectorImpl(StrViewVector& vec, StrViewCref name, StrViewCref section) {
+    auto readVectorImpl(StrViewCref str, StrViewCref name, StrViewCref section) {
         auto res = ScmVector<T>{};
 
-        for (auto& s : vec)
-            res.push_back(superCast<T>(s, name, section));
+        // Upper bound: commas inside quotes or nested lists only overestimate
+        res.reserve(static_cast<SizeT>(std::count(str.begin(), str.end(), ',')) + 1);
+
+        unpackEach(name, section, str, 0, [&](StrViewCref elem) {
+            res.push_back(superCast<T>(elem, name, section));
+        });
 
         return res;
     }
@@ -315,8 +2016,104 @@ namespace scm_details {
     template <typename A, typename T>
     auto superCast(StrViewCref str, StrViewCref name, StrViewCref section)
     -> std::enable_if_t<SCM_NAMESPACE::any_of<A, ScmVector<T>, std::vector<T>>, A> {
-        auto vec = unpack(name, section, str, 0);
-        return readVectorImpl<T>(vec, name, section);
+        return readVectorImpl<T>(str, name, section);
+    }
+
+    /**
+     * Read value using preparsed scalar if it has suitable type, otherwise convert text
+     */
+    template <typename T>
+    auto readValue(const Value& val, StrViewCref name, StrViewCref section) -> T {
+        if constexpr (std::is_same_v<T, bool>) {
+            if (val.type() == ValueType::Bool)
+                return val.boolean();
+        }
+        else if constexpr (std::is_integral_v<T>) {
+            auto i = val.integer();
+
+            if (val.type() == ValueType::Int) {
+                if constexpr (std::is_signed_v<T>) {
+                    if (i >= std::numeric_limits<T>::min() && i <= std::numeric_limits<T>::max())
+                        return static_cast<T>(i);
+                }
+                else if (i >= 0 && static_cast<std::uint64_t>(i) <= std::numeric_limits<T>::max()) {
+                    return static_cast<T>(i);
+                }
+            }
+        }
+        else if constexpr (std::is_same_v<T, double>) {
+            if (val.type() == ValueType::Float)
+                return val.real();
+            // Integers are exact up to 2^53
+            if (val.type() == ValueType::Int && val.integer() >= -(1LL << 53) && val.integer() <= (1LL << 53))
+                return static_cast<double>(val.integer());
+        }
+        else if constexpr (std::is_same_v<T, float>) {
+            if (val.type() == ValueType::Float)
+                return val.real32();
+            // Integers are exact up to 2^24
+            if (val.type() == ValueType::Int && val.integer() >= -(1LL << 24) && val.integer() <= (1LL << 24))
+                return static_cast<float>(val.integer());
+        }
+
+        return superCast<T>(val.text(), name, section);
+    }
+
+    /**
+     * Binding of class member to the key. Created by SCM_BIND
+     */
+    template <typename C, typename M>
+    struct BindField {
+        StrView key;
+        M C::*  member;
+    };
+
+    template <typename C, typename M>
+    constexpr auto makeBindField(StrViewCref key, M C::* member) {
+        return BindField<C, M>{key, member};
+    }
+
+    template <typename T, typename C, typename M>
+    void bindField(T& obj, const CfgData& data, const Section& sect, const BindField<C, M>& field,
+                   bool required, StringRef errors) {
+        auto str = data.findValue(sect, field.key);
+
+        if (!str) {
+            if (required)
+                errors += SCM_NAMESPACE::str_join("\n    Can't find key '", field.key, "'");
+            return;
+        }
+
+#if defined(SCM_ASSERTS) || defined(SCM_FMT_ASSERTS)
+        obj.*field.member = readValue<M>(*str, field.key, sect.name());
+#else
+        try {
+            obj.*field.member = readValue<M>(*str, field.key, sect.name());
+        }
+        catch (const std::exception& e) {
+            errors += "\n    ";
+            errors += e.what();
+        }
+#endif
+    }
+
+    /**
+     * Fill all fields declared with SCM_BIND from section
+     * Errors are collected and reported at once
+     * @param obj - object to be filled
+     * @param data - data with the section and its ancestors
+     * @param sect - section
+     * @param required - if false, members with missing keys stay unchanged
+     */
+    template <typename T>
+    void bindSection(T& obj, const CfgData& data, const Section& sect, bool required) {
+        auto errors = String();
+
+        std::apply([&](const auto&... fields) {
+            (bindField(obj, data, sect, fields, required, errors), ...);
+        }, scm_bind_fields(static_cast<const T*>(nullptr)));
+
+        SCM_EXCEPTION(CfgException, errors.empty(), "Can't bind section [", sect.name(), "]:", errors);
     }
 
     template <typename T>
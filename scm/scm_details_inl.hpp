@@ -1,517 +1,1363 @@
 #pragma once
 namespace scm_details {
+    enum CharClass : unsigned char {
+        CC_PLAIN  = 1 << 0, // a-z, A-Z, '_'
+        CC_DIGIT  = 1 << 1, // 0-9
+        CC_LEGAL  = 1 << 2, // Legal name symbols: '@', '.', '/', '\\', '-'
+        CC_SPACE  = 1 << 3, // ' ', '\t'
+        CC_QUOTE  = 1 << 4, // '\'', '"'
+        CC_SYMBOL = 1 << 5, // Other symbols allowed outside quotes
+        CC_BREAK  = 1 << 6, // Symbols which may break plain text in value: '$', ';', '/'
+
+        CC_NAME   = CC_PLAIN | CC_DIGIT | CC_LEGAL
+    };
+
+    constexpr auto make_char_table() {
+        auto table = std::array<unsigned char, 256>{};
+
+        for (int c = 'a'; c <= 'z'; ++c) table[c] |= CC_PLAIN;
+        for (int c = 'A'; c <= 'Z'; ++c) table[c] |= CC_PLAIN;
+        for (int c = '0'; c <= '9'; ++c) table[c] |= CC_DIGIT;
+
+        table['_'] |= CC_PLAIN;
+
+        for (auto c : {'@', '.', '/', '\\', '-'})                               table[c] |= CC_LEGAL;
+        for (auto c : {' ', '\t'})                                             table[c] |= CC_SPACE;
+        for (auto c : {'\'', '\"'})                                            table[c] |= CC_QUOTE;
+        for (auto c : {',', ';', '#', '[', ']', '+', '=', '$', '{', '}', ':'}) table[c] |= CC_SYMBOL;
+        for (auto c : {'$', ';', '/'})                                         table[c] |= CC_BREAK;
+
+        return table;
+    }
+
+    inline constexpr auto char_table = make_char_table();
+
+    inline unsigned char char_class(ScmChar8 c) {
+        return char_table[static_cast<unsigned char>(c)];
+    }
+
     inline bool is_plain_text(ScmChar8 c) {
-        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+        return char_class(c) & CC_PLAIN;
     }
 
     inline bool is_digit(ScmChar8 c) {
-        return c >= '0' && c <= '9';
+        return char_class(c) & CC_DIGIT;
     }
 
     inline bool is_space(ScmChar8 c) {
-        return c == ' ' || c == '\t';
+        return char_class(c) & CC_SPACE;
     }
 
     inline bool is_bracket(ScmChar8 c) {
-        return c == '\'' || c == '\"';
+        return char_class(c) & CC_QUOTE;
     }
 
     inline bool is_legal_name_symbol(ScmChar8 c) {
-        return c == '@' || c == '.' || c =='/' || c == '\\' || c == '-';
+        return char_class(c) & CC_LEGAL;
     }
 
     inline bool is_symbol(ScmChar8 c) {
-        return c == ',' || c == ';' || c == '#' || c == '[' || c == ']' ||
-               c == '+' || c == '=' || c == '$' || c == '{' || c == '}' ||
-               c == ':' || is_legal_name_symbol(c) || is_bracket(c);
+        return char_class(c) & (CC_SYMBOL | CC_LEGAL | CC_QUOTE);
     }
 
     inline bool validate_name_symbol(ScmChar8 c) {
-        return is_plain_text(c) || is_digit(c) || is_legal_name_symbol(c);
+        return char_class(c) & CC_NAME;
     }
 
     inline bool validate_keyval(ScmChar8 c) {
-        return validate_name_symbol(c) || is_space(c) || c == '-' || c == '+';
+        return (char_class(c) & (CC_NAME | CC_SPACE)) || c == '+';
     }
 
     inline bool validate_symbol(ScmChar8 c) {
-        return is_space(c) || is_digit(c) || is_plain_text(c) || is_symbol(c);
+        return char_class(c) != 0;
+    }
+
+    inline auto remove_brackets_if_exists(StrViewCref str) -> StrView {
+        if (str.length() > 1 && is_bracket(str.front()) && str.back() == str.front())
+            return str.substr(1, str.length() - 2);
+        return str;
+    }
+
+    inline bool is_comment_start(const ScmChar8* ptr, const ScmChar8* end) {
+        return *ptr == ';' || (*ptr == '/' && ptr + 1 != end && *(ptr + 1) == '/');
     }
 
-    // Skip spaces, return true if end passed
-    template <typename IterT>
-    inline bool skip_spaces_if_no_endl(IterT& ptr, IterT end) {
-        while(is_space(*ptr) && ptr != end)
+    // Skip spaces, return true if end of line or comment reached
+    inline bool skip_spaces_to_eol(const ScmChar8*& ptr, const ScmChar8* end) {
+        while (ptr != end && is_space(*ptr))
             ++ptr;
 
-        return ptr == end;
+        return ptr == end || is_comment_start(ptr, end);
+    }
+
+    inline auto view_of(const ScmChar8* start, const ScmChar8* end) -> StrView {
+        return StrView(start, static_cast<SizeT>(end - start));
     }
 
-    // Skip spaces, return true if beg passed
-    template <typename IterT>
-    inline bool rskip_spaces_if_no_beg(IterT& ptr, IterT beg) {
-        while(is_space(*ptr) && ptr != beg)
-            --ptr;
+    inline void check_symbol(StrViewCref path, SizeT lineNum, ScmChar8 c) {
+        SCM_EXCEPTION(CfgException, validate_symbol(c),
+                      "Undefined char symbol '", String(1, c), "' [", std::to_string(unsigned(c)).data(),
+                      "] in ", path, ":", std::to_string(lineNum + 1).data());
+    }
+
+    inline void check_name_symbol(StrViewCref path, SizeT lineNum, ScmChar8 c, const char* where) {
+        check_symbol(path, lineNum, c);
 
-        return ptr == beg;
+        SCM_EXCEPTION(CfgException, validate_name_symbol(c),
+                      "Invalid character '", String(1, c), "' in ", where, " in ", path, ":",
+                      std::to_string(lineNum + 1).data());
     }
 
-    inline auto remove_space_bounds_if_exists(StrViewCref str) -> StrView {
-        auto start = str.cbegin();
-        auto last  = str.cend() - 1;
+    // Read name until space, end of line, comment or one of terminators
+    template <typename... Terms>
+    auto tokenizeName(StrViewCref path, SizeT lineNum, const ScmChar8*& ptr, const ScmChar8* end,
+                      const char* where, Terms... terms) -> StrView {
+        auto start = ptr;
+
+        for (; ptr != end; ++ptr) {
+            auto c = *ptr;
 
-        if (!skip_spaces_if_no_endl(start, last)) {
-            if (!rskip_spaces_if_no_beg(last, start))
-                return str.substr(start - str.cbegin(), last - start + 1);
+            if (!(char_class(c) & CC_NAME)) {
+                if (is_space(c) || ((c == terms) || ...) || c == ';')
+                    break;
+                check_name_symbol(path, lineNum, c, where);
+            }
+            else if (c == '/' && is_comment_start(ptr, end)) {
+                break;
+            }
         }
 
-        return str;
+        return view_of(start, ptr);
     }
 
-    inline auto remove_brackets_if_exists(StrViewCref str) -> StrView {
-        if (str.length() > 1 && is_bracket(str.front()) && str.back() == str.front())
-            return str.substr(1, str.length() - 2);
-        return str;
+    // Read quoted text, ptr must point to the opening quote
+    auto tokenizeQuoted(StrViewCref path, SizeT lineNum, const ScmChar8*& ptr, const ScmChar8* end) -> StrView {
+        auto quote = *ptr;
+        auto start = ++ptr;
+
+        while (ptr != end && *ptr != quote)
+            ++ptr;
+
+        SCM_EXCEPTION(CfgException, ptr != end, "Missing second ", String(1, quote), " quote in ", path, ":",
+                      std::to_string(lineNum + 1).data());
+
+        auto text = view_of(start, ptr);
+
+        if (ptr != end)
+            ++ptr; // Skip closing quote
+
+        return text;
     }
 
-    auto unpackVariable (StrViewCref path, SizeT lineNum, StrViewCref line, Section* current_sect = nullptr) -> String {
-        auto ptr = line.begin();
+    void tokenizeSection(StrViewCref path, SizeT lineNum, const ScmChar8*& ptr, const ScmChar8* end,
+                         TokenVector& tokens) {
+        auto start = ++ptr; // Skip '['
+
+        ////////////// Read section
 
-        bool onSingleQuotes = false;
-        bool onDoubleQuotes = false;
+        SCM_EXCEPTION(CfgException, ptr != end, "Missing close section bracket in ", path, ":",
+                      std::to_string(lineNum + 1).data());
 
-        auto result = String();
-        result.reserve(line.length());
+        SCM_EXCEPTION(CfgException, !is_digit(*ptr) && !is_legal_name_symbol(*ptr),
+                      "Starting section with symbol '", String(1, *ptr), "' in ", path, ":",
+                      std::to_string(lineNum + 1).data());
 
-        for (; ptr != line.cend();) {
-            if (*ptr == '\'' && !onDoubleQuotes)
-                onSingleQuotes = !onSingleQuotes;
+        while (ptr != end && *ptr != ']' && !is_comment_start(ptr, end)) {
+            check_name_symbol(path, lineNum, *ptr, "section definition");
+            ++ptr;
+        }
 
-            else if (*ptr == '\"' && !onSingleQuotes)
-                onDoubleQuotes = !onDoubleQuotes;
+        SCM_EXCEPTION(CfgException, ptr != end && *ptr == ']', "Missing close section bracket in ", path, ":",
+                      std::to_string(lineNum + 1).data());
 
-            else if (onSingleQuotes || onDoubleQuotes) {
-                result.push_back(*ptr);
-            }
-            else {
-                if (*ptr == '$') {
-                    ++ptr; // Skip '$'
+        auto name = view_of(start, ptr);
+        tokens.push_back(Token{TokenType::Section, lineNum, name, StrView()});
 
-                    ////////// Read key
+        ++ptr; // Skip ']'
 
-                    SCM_EXCEPTION(CfgException, !skip_spaces_if_no_endl(ptr, line.cend()),
-                                  "Empty key after '$' in ", path, ":", std::to_string(lineNum + 1).data());
+        if (skip_spaces_to_eol(ptr, end))
+            return;
 
-                    SCM_EXCEPTION(CfgException, !is_digit(*ptr) && !is_legal_name_symbol(*ptr),
-                                  "Starting key with symbol '", String(1, *ptr), "' in ", path, ":",
-                                  std::to_string(lineNum + 1).data());
+        /////////////// Read parents
 
-                    auto start = ptr;
+        SCM_EXCEPTION(CfgException, *ptr == ':',
+                      "Unexpected symbol '", String(1, *ptr), "' after section [", name,
+                      "] definition in ", path, ":", std::to_string(lineNum + 1).data());
 
-                    while(!is_space(*ptr) && *ptr != ':' && ptr != line.cend() && *ptr != '}' && *ptr != ',') {
-                        SCM_EXCEPTION(CfgException, validate_name_symbol(*ptr),
-                                      "Invalid character '", String(1, *ptr), "' in key after '$' in ", path, ":",
-                                      std::to_string(lineNum + 1).data());
+        SCM_EXCEPTION(CfgException, name != GLOBAL_NAMESPACE,
+                      "Attempt to define parents for global section in ", path, ":",
+                      std::to_string(lineNum + 1).data());
 
-                        ++ptr;
-                    }
+        ++ptr; // Skip ':'
 
-                    auto val   = StrView();
-                    auto first = String(line.substr(start - line.cbegin(), ptr - start));
+        SCM_EXCEPTION(CfgException, !skip_spaces_to_eol(ptr, end),
+                      "Missing parents sections after ':' in ", path, ":", std::to_string(lineNum + 1).data());
 
-                    skip_spaces_if_no_endl(ptr, line.cend());
+        while (true) {
+            SCM_EXCEPTION(CfgException, !is_digit(*ptr) && !is_legal_name_symbol(*ptr),
+                          "Starting parent definition with symbol '", String(1, *ptr), "' in ", path, ":",
+                          std::to_string(lineNum + 1).data());
 
-                    ////////// Dereference key
-                    if (ptr == line.cend() || *ptr != ':') {
-                        auto mval = std::optional<String>();
+            auto parent = tokenizeName(path, lineNum, ptr, end, "parent definition", ',');
+            tokens.push_back(Token{TokenType::Parent, lineNum, parent, StrView()});
 
-                        // If current section exists read from this first
-                        if (current_sect) {
-                            mval = current_sect->valueOpt(first);
-                        }
+            if (skip_spaces_to_eol(ptr, end))
+                break;
 
-                        if (mval)
-                            val = *mval;
-                        else
-                            val = cfg_data().getValue(String(GLOBAL_NAMESPACE), first);
-                    }
-                    else if (*ptr == ':'){
-                        //////// Read value from section (only no-parents section supported)
-                        ++ptr; // skip ':'
+            SCM_EXCEPTION(CfgException, *ptr == ',', "Missing ',' after parent definition in ", path, ":",
+                          std::to_string(lineNum + 1).data());
 
-                        SCM_EXCEPTION(CfgException, !skip_spaces_if_no_endl(ptr, line.cend()),
-                                      "Empty key after ':' in ", path, ":", std::to_string(lineNum + 1).data());
+            ++ptr; // Skip ','
 
-                        SCM_EXCEPTION(CfgException, !is_digit(*ptr) && !is_legal_name_symbol(*ptr),
-                                      "Starting key with symbol '", String(1, *ptr), "' in ", path, ":",
-                                      std::to_string(lineNum + 1).data());
+            SCM_EXCEPTION(CfgException, !skip_spaces_to_eol(ptr, end),
+                          "Missing parent definition after ',' in ", path, ":", std::to_string(lineNum + 1).data());
+        }
+    }
 
-                        auto start2 = ptr;
+    void tokenizeDirective(StrViewCref path, SizeT lineNum, const ScmChar8*& ptr, const ScmChar8* end,
+                           TokenVector& tokens) {
+        ++ptr; // Skip '#'
 
-                        while(!is_space(*ptr) && *ptr != ':' && ptr != line.cend()) {
-                            SCM_EXCEPTION(CfgException, validate_name_symbol(*ptr),
-                                          "Invalid character '", String(1, *ptr), "' in key after '$' in ", path, ":",
-                                          std::to_string(lineNum + 1).data());
+        SCM_EXCEPTION(CfgException, !skip_spaces_to_eol(ptr, end),
+                      "Empty preprocessor directive in ", path, ":", std::to_string(lineNum + 1).data());
 
-                            ++ptr;
-                        }
+        auto start = ptr;
 
-                        auto second = line.substr(start2 - line.cbegin(), ptr - start2);
-                        SCM_EXCEPTION(CfgException, cfg_data().getSection(first).getParents().empty(),
-                                      "Attempt to dereference key '", second, "' from section [", first, "] with parent ",
-                                      "in ", path, ":", std::to_string(lineNum + 1).data());
+        while (ptr != end && !is_space(*ptr) && !is_comment_start(ptr, end)) {
+            SCM_EXCEPTION(CfgException, is_plain_text(*ptr), "Invalid character in preprocessor directive in ", path, ":",
+                          std::to_string(lineNum + 1).data());
+            ++ptr;
+        }
 
-                        val = cfg_data().getValue(first, String(second));
-                    }
+        auto name = view_of(start, ptr);
 
-                    result += remove_brackets_if_exists(val);
-                    continue;
-                }
-                else if (!is_space(*ptr)) {
-                    result.push_back(*ptr);
-                }
+        ////////////// Read argument (everything up to the end of line, quotes are removed)
+
+        skip_spaces_to_eol(ptr, end);
+
+        auto argStart = ptr;
+        auto argEnd   = ptr;
+
+        while (ptr != end) {
+            if (is_bracket(*ptr)) {
+                tokenizeQuoted(path, lineNum, ptr, end);
+                argEnd = ptr;
+            }
+            else if (is_comment_start(ptr, end)) {
+                break;
             }
+            else {
+                check_symbol(path, lineNum, *ptr);
 
-            ++ptr;
+                if (!is_space(*ptr++))
+                    argEnd = ptr;
+            }
         }
 
-        return std::move(result);
+        tokens.push_back(Token{TokenType::Directive, lineNum, name, remove_brackets_if_exists(view_of(argStart, argEnd))});
     }
 
+    void tokenizeReference(StrViewCref path, SizeT lineNum, const ScmChar8*& ptr, const ScmChar8* end,
+                           TokenVector& tokens) {
+        ++ptr; // Skip '$'
 
-    auto pairFromLine(StrViewCref path, SizeT lineNum, StrViewCref line) -> StrViewPair {
-        auto ptr = line.cbegin();
+        SCM_EXCEPTION(CfgException, !skip_spaces_to_eol(ptr, end),
+                      "Empty key after '$' in ", path, ":", std::to_string(lineNum + 1).data());
 
-        if (skip_spaces_if_no_endl(ptr, line.cend()))
-            return {};
+        SCM_EXCEPTION(CfgException, is_plain_text(*ptr),
+                      "Starting key with symbol '", String(1, *ptr), "' in ", path, ":",
+                      std::to_string(lineNum + 1).data());
 
-        /////////// Read name
+        auto first = tokenizeName(path, lineNum, ptr, end, "key after '$'", ':', '}', ',');
 
-        auto start = ptr;
+        // $key
+        if (skip_spaces_to_eol(ptr, end) || *ptr != ':') {
+            tokens.push_back(Token{TokenType::Reference, lineNum, StrView(), first});
+            return;
+        }
+
+        // $section:key
+        ++ptr; // Skip ':'
+
+        SCM_EXCEPTION(CfgException, !skip_spaces_to_eol(ptr, end),
+                      "Empty key after ':' in ", path, ":", std::to_string(lineNum + 1).data());
 
         SCM_EXCEPTION(CfgException, !is_digit(*ptr) && !is_legal_name_symbol(*ptr),
                       "Starting key with symbol '", String(1, *ptr), "' in ", path, ":",
                       std::to_string(lineNum + 1).data());
 
-        while(!is_space(*ptr) && *ptr != '=' && ptr != line.cend()) {
+        auto second = tokenizeName(path, lineNum, ptr, end, "key after '$'", ':', '}', ',');
 
-            SCM_EXCEPTION(CfgException, validate_name_symbol(*ptr),
-                          "Invalid character '", String(1, *ptr), "' in key definition '$' in ", path, ":",
-                          std::to_string(lineNum + 1).data());
+        tokens.push_back(Token{TokenType::Reference, lineNum, first, second});
+    }
 
-            ++ptr;
-        }
+    void tokenizeKeyValue(StrViewCref path, SizeT lineNum, const ScmChar8*& ptr, const ScmChar8* end,
+                          TokenVector& tokens) {
+        /////////// Read name
 
-        auto key = line.substr(start - line.cbegin(), ptr - start);
+        SCM_EXCEPTION(CfgException, !is_digit(*ptr) && !is_legal_name_symbol(*ptr),
+                      "Starting key with symbol '", String(1, *ptr), "' in ", path, ":",
+                      std::to_string(lineNum + 1).data());
 
+        auto key = tokenizeName(path, lineNum, ptr, end, "key definition", '=');
 
-        //////////// Read values (no space deleting inside values)
-        SCM_EXCEPTION(CfgException, !skip_spaces_if_no_endl(ptr, line.cend()),
-                      "Missing value at key '", key, "' in ", path, ":",
-                      std::to_string(lineNum + 1).data());
+        SCM_EXCEPTION(CfgException, !skip_spaces_to_eol(ptr, end),
+                      "Missing value at key '", key, "' in ", path, ":", std::to_string(lineNum + 1).data());
 
         SCM_EXCEPTION(CfgException, *ptr == '=', "Missing delimiter '=' at key '", key, "' in ", path, ":",
                       std::to_string(lineNum + 1).data());
 
-        ++ptr;
+        ++ptr; // Skip '='
 
-        auto value = remove_space_bounds_if_exists(line.substr(ptr - line.cbegin(), line.end() - ptr));
+        tokens.push_back(Token{TokenType::Key, lineNum, key, StrView()});
 
-        SCM_EXCEPTION(CfgException, !value.empty(), "Missing value at key '", key, "' in ", path, ":",
-                      std::to_string(lineNum + 1).data());
+        SCM_EXCEPTION(CfgException, ptr != end && !is_comment_start(ptr, end),
+                      "Missing value at key '", key, "' in ", path, ":", std::to_string(lineNum + 1).data());
+
+        //////////// Read value: quoted text is kept as is, spaces outside quotes are dropped
+
+        while (ptr != end) {
+            if (is_space(*ptr)) {
+                ++ptr;
+                continue;
+            }
+
+            if (is_comment_start(ptr, end))
+                break;
+
+            if (is_bracket(*ptr)) {
+                tokens.push_back(Token{TokenType::Literal, lineNum, tokenizeQuoted(path, lineNum, ptr, end), StrView()});
+            }
+            else if (*ptr == '$') {
+                tokenizeReference(path, lineNum, ptr, end, tokens);
+            }
+            else {
+                auto start = ptr;
 
-        return StrViewPair(key, value);
+                for (; ptr != end; ++ptr) {
+                    auto cc = char_class(*ptr);
+
+                    if (cc & (CC_SPACE | CC_QUOTE | CC_BREAK)) {
+                        if (*ptr != '/' || is_comment_start(ptr, end))
+                            break;
+                    }
+                    else if (!cc) {
+                        check_symbol(path, lineNum, *ptr);
+                    }
+                }
+
+                tokens.push_back(Token{TokenType::Literal, lineNum, view_of(start, ptr), StrView()});
+            }
+        }
     }
 
+    void tokenizeLine(StrViewCref path, SizeT lineNum, StrViewCref line, TokenVector& tokens) {
+        auto ptr = line.data();
+        auto end = ptr + line.size();
 
-    void deleteComments(StrViewCref path, StrViewVector& lines) {
-        for (SizeT n = 0; n < lines.size(); ++n) {
-            bool onSingleQuotes = false;
-            bool onDoubleQuotes = false;
+        if (skip_spaces_to_eol(ptr, end))
+            return;
 
-            auto& line = lines[n];
-            auto  i    = line.begin();
+        if (*ptr == '[')
+            tokenizeSection(path, lineNum, ptr, end, tokens);
+        else if (*ptr == '#')
+            tokenizeDirective(path, lineNum, ptr, end, tokens);
+        else
+            tokenizeKeyValue(path, lineNum, ptr, end, tokens);
+    }
 
-            for (; i != line.end(); ++i) {
-                if (*i == '\'' && !onDoubleQuotes)
-                    onSingleQuotes = !onSingleQuotes;
+    auto tokenize(StrViewCref path, StrViewCref text) -> TokenVector {
+        auto lines  = SCM_NAMESPACE::split_lines(text);
+        auto tokens = TokenVector();
 
-                else if (*i == '\"' && !onSingleQuotes)
-                    onDoubleQuotes = !onDoubleQuotes;
+        tokens.reserve(lines.size() * 3);
 
-                else if (!onSingleQuotes && !onDoubleQuotes) {
-                    SCM_EXCEPTION(CfgException, validate_symbol(*i),
-                                  "Undefined char symbol '", String(1, *i), "' [", std::to_string(unsigned(*i)).data(),
-                                  "] in ", path, ":", std::to_string(n + 1).data());
+        auto lineNum = SizeT(0);
 
-                    if (*i == ';' || (*i == '/' && *(i + 1) == '/')) {
-                        line = line.substr(0, i - line.begin());
-                        break;
-                    }
-                }
+        for (auto& line : lines) {
+            // split_lines gives empty line between '\r' and '\n', it isn't counted in line numbers
+            auto pos = static_cast<SizeT>(line.data() - text.data());
+
+            if (line.empty() && pos != 0 && pos != text.size() && text[pos - 1] == '\r' && text[pos] == '\n')
+                continue;
+
+            tokenizeLine(path, lineNum++, line, tokens);
+        }
+
+        return tokens;
+    }
+
+
+    // Join value parts following the key token at position 'i' and store the result to arena.
+    // Value with references is added to interpolations of data and resolved later (see resolveReferences).
+    // On return 'i' points to the last part of value
+    auto joinValue(CfgData& data, StrViewCref path, const TokenVector& tokens, SizeT& i, Section& section,
+                   StrViewCref key, StringRef buffer)
+    -> Value {
+        auto start = i + 1;
+        auto stop  = start;
+        bool refs  = false;
+
+        while (stop < tokens.size() &&
+               (tokens[stop].type == TokenType::Literal || tokens[stop].type == TokenType::Reference)) {
+            refs = refs || tokens[stop].type == TokenType::Reference;
+            ++stop;
+        }
+
+        i = stop - 1;
+
+        // Plain value
+        if (stop - start == 1 && !refs)
+            return data.store(tokens[start].first);
+
+        if (!refs) {
+            buffer.clear();
+
+            for (auto n = start; n != stop; ++n)
+                buffer += tokens[n].first;
+
+            return data.store(buffer);
+        }
+
+        auto& pending = data.interpolations();
+        auto  index   = pending.values.size();
+
+        pending.values.push_back(Interpolation{path, &section, key, pending.parts.size(), stop - start});
+
+        for (auto n = start; n != stop; ++n) {
+            auto& tok = tokens[n];
+            auto first = tok.type == TokenType::Literal ? data.store(tok.first) : data.intern(tok.first);
+            pending.parts.push_back(Token{tok.type, tok.lineNum, first, data.intern(tok.second)});
+        }
+
+        return Value(StrView(), ValueType::Pending, index, 0);
+    }
+
+    /**
+     * Find value referenced by part of interpolation
+     * @param index - index of the interpolation, $key in its own definition refers to global key
+     * @return Value and unit which it belongs to
+     */
+    auto findReference(const CfgData& data, const Section& global, const Interpolation& value, SizeT index,
+                       const Token& ref)
+    -> ScmPair<const Value*, Unit> {
+        auto line = [&] { return std::to_string(ref.lineNum + 1); };
+        auto self = [&](const Value* target) { return target->type() == ValueType::Pending && target->payload() == index; };
+
+        ////////// $key: read from current section first, then from global
+        if (ref.first.empty()) {
+            if (value.section != &global) {
+                auto target = std::as_const(*value.section).find(ref.second);
+                if (target && !self(target))
+                    return {target, Unit(value.path, value.section->name())};
             }
 
-            SCM_EXCEPTION(CfgException, !onSingleQuotes, "Missing second \' quote in ", path, ":", std::to_string(n + 1).data());
-            SCM_EXCEPTION(CfgException, !onDoubleQuotes, "Missing second \" quote in ", path, ":", std::to_string(n + 1).data());
+            auto target = global.find(ref.second);
+
+            SCM_EXCEPTION(CfgException, target && !self(target),
+                          "Can't find key '", ref.second, "' referenced in ", value.path, ":", line().data());
+
+            return {target, Unit(StrView(), GLOBAL_NAMESPACE)};
         }
+
+        ////////// $section:key (only no-parents section supported)
+        auto sect = data.findSection(ref.first);
+
+        SCM_EXCEPTION(CfgException, sect,
+                      "Can't find section [", ref.first, "] referenced in ", value.path, ":", line().data());
+
+        SCM_EXCEPTION(CfgException, sect->getParents().empty(),
+                      "Attempt to dereference key '", ref.second, "' from section [", ref.first, "] with parent ",
+                      "in ", value.path, ":", line().data());
+
+        auto target = sect->find(ref.second);
+
+        SCM_EXCEPTION(CfgException, target && !self(target),
+                      "Can't find key '", ref.second, "' in section [", ref.first, "] referenced in ",
+                      value.path, ":", line().data());
+
+        return {target, Unit(sect->file(), sect->name())};
     }
 
-    void processFileTask(StrViewCref path);
+    /**
+     * Resolve all interpolations of data. Every value is resolved once, after values which it references,
+     * values of one level of the reference graph are joined in parallel. Dependencies between units are
+     * added to the graph
+     */
+    void resolveReferences(CfgData& data, TaskPool& pool) {
+        constexpr SizeT valuesPerTask = 1024;
 
-    void preprocessorTask(StrViewCref path, SizeT lineNum, StrViewCref line) {
-        auto ptr = line.cbegin();
+        auto& pending = data.interpolations();
+        auto& values  = pending.values;
+        auto& parts   = pending.parts;
 
-        ++ptr; // skip '#'
+        if (values.empty())
+            return;
 
-        SCM_EXCEPTION(CfgException, !skip_spaces_if_no_endl(ptr, line.cend()),
-                      "Empty preprocessor directive in ", path, ":", std::to_string(lineNum + 1).data());
+        auto& global = *std::as_const(data).findSection(GLOBAL_NAMESPACE);
 
-        auto start = ptr;
+        // Value waits for interpolations which it references. Edges are (referenced, value)
+        auto targets = ScmVector<const Value*>(parts.size(), nullptr);
+        auto waits   = ScmVector<SizeT>(values.size(), 0);
+        auto edges   = ScmVector<ScmPair<SizeT, SizeT>>();
+        auto deps    = ScmVector<ScmPair<Unit, Unit>>();
+        auto level   = ScmVector<SizeT>();
 
-        while (!is_space(*ptr) && ptr != line.cend()) {
+        for (SizeT i = 0; i < values.size(); ++i) {
+            auto& value = values[i];
+            auto  unit  = Unit(value.path, value.section->name());
 
-            SCM_EXCEPTION(CfgException, is_plain_text(*ptr), "Invalid character in preprocessor directive in ", path, ":",
-                          std::to_string(lineNum + 1).data());
+            for (auto n = value.first; n != value.first + value.count; ++n) {
+                if (parts[n].type != TokenType::Reference)
+                    continue;
 
-            ++ptr;
+                auto [target, dependency] = findReference(data, global, value, i, parts[n]);
+
+                targets[n] = target;
+
+                if (dependency != unit)
+                    deps.emplace_back(unit, dependency);
+
+                if (target->type() == ValueType::Pending) {
+                    edges.emplace_back(static_cast<SizeT>(target->payload()), i);
+                    ++waits[i];
+                }
+            }
+
+            if (waits[i] == 0)
+                level.push_back(i);
+        }
+
+        data.graph().addDependencies(deps);
+
+        // Values which wait for value v are children[offsets[v]] .. children[offsets[v + 1] - 1]
+        auto offsets  = ScmVector<SizeT>(values.size() + 1, 0);
+        auto children = ScmVector<SizeT>(edges.size());
+
+        for (auto& edge : edges)
+            ++offsets[edge.first + 1];
+
+        std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+        auto fill = ScmVector<SizeT>(offsets.begin(), offsets.end() - 1);
+        for (auto& edge : edges)
+            children[fill[edge.first]++] = edge.second;
+
+        // Values of one task are joined to one string, which is stored at once
+        auto texts    = StrVector();
+        auto ends     = ScmVector<SizeT>();
+        auto resolved = SizeT(0);
+
+        while (!level.empty()) {
+            auto tasks  = ScmVector<std::future<void>>();
+            auto chunks = (level.size() + valuesPerTask - 1) / valuesPerTask;
+
+            texts.assign(chunks, String());
+            ends.assign(level.size(), 0);
+
+            for (SizeT chunk = 0; chunk < chunks; ++chunk) {
+                auto join = [&, chunk] {
+                    auto& text = texts[chunk];
+                    auto  last = std::min((chunk + 1) * valuesPerTask, level.size());
+
+                    for (auto j = chunk * valuesPerTask; j < last; ++j) {
+                        auto& value = values[level[j]];
+
+                        for (auto n = value.first; n != value.first + value.count; ++n)
+                            text += targets[n] ? remove_brackets_if_exists(targets[n]->text()) : parts[n].first;
+
+                        ends[j] = text.size();
+                    }
+                };
+
+                // Small levels don't start the pool
+                if (chunks == 1)
+                    join();
+                else
+                    tasks.push_back(pool.submit(join));
+            }
+
+            for (auto& task : tasks)
+                task.wait();
+            for (auto& task : tasks)
+                task.get();
+
+            auto next = ScmVector<SizeT>();
+
+            for (SizeT chunk = 0; chunk < chunks; ++chunk) {
+                auto text  = data.store(texts[chunk]);
+                auto begin = SizeT(0);
+                auto last  = std::min((chunk + 1) * valuesPerTask, level.size());
+
+                for (auto j = chunk * valuesPerTask; j < last; ++j) {
+                    auto& value = values[level[j]];
+
+                    value.section->getMap().find(value.key)->second = Value(text.substr(begin, ends[j] - begin));
+                    begin = ends[j];
+
+                    for (auto n = offsets[level[j]]; n != offsets[level[j] + 1]; ++n)
+                        if (--waits[children[n]] == 0)
+                            next.push_back(children[n]);
+                }
+            }
+
+            resolved += level.size();
+            level = std::move(next);
         }
 
-        auto first    = line.substr(start - line.cbegin(), ptr - start);
-        auto backline = line.substr(ptr - line.cbegin(), line.cend() - ptr);
+        if (resolved != values.size()) {
+            // Every unresolved value references another unresolved value, following them leads to a cycle
+            auto path = ScmVector<SizeT>();
+            auto i    = static_cast<SizeT>(std::find_if(waits.begin(), waits.end(), [](auto w) { return w != 0; }) -
+                                           waits.begin());
 
-        if (first == "include") {
-            auto appendPath = remove_brackets_if_exists(remove_space_bounds_if_exists(backline));
+            while (std::find(path.begin(), path.end(), i) == path.end()) {
+                path.push_back(i);
 
-            SCM_EXCEPTION(CfgException, !appendPath.empty(),
+                for (auto n = values[i].first; n != values[i].first + values[i].count; ++n) {
+                    auto target = targets[n];
+                    if (target && target->type() == ValueType::Pending && waits[target->payload()] != 0) {
+                        i = static_cast<SizeT>(target->payload());
+                        break;
+                    }
+                }
+            }
+
+            auto cycle = String();
+            for (auto n = std::find(path.begin(), path.end(), i); n != path.end(); ++n)
+                cycle += SCM_NAMESPACE::str_join("[", values[*n].section->name(), "] ", values[*n].key, " -> ");
+
+            SCM_EXCEPTION(CfgException, false, "Interpolation cycle ", cycle, "[", values[i].section->name(), "] ",
+                          values[i].key, " in ", values[i].path);
+        }
+
+        pending = Interpolations();
+    }
+
+    // Check directive, return path of included file or empty string if directive isn't an include
+    auto preprocessorTask(StrViewCref path, const Token& directive) -> String {
+        if (directive.first == "include") {
+            SCM_EXCEPTION(CfgException, !directive.second.empty(),
                           "Empty path in include directive in ", path, ":",
-                          std::to_string(lineNum + 1).data());
+                          std::to_string(directive.lineNum + 1).data());
 
-            processFileTask(SCM_NAMESPACE::append_path(SCM_NAMESPACE::parent_path(path), String(appendPath)));
+            return SCM_NAMESPACE::append_path(SCM_NAMESPACE::parent_path(path), String(directive.second));
         } else {
-            SCM_EXCEPTION(CfgException, 0, "Unknown preprocessor directive '#", first, "' in ", path, ":",
-                          std::to_string(lineNum + 1).data());
+            SCM_EXCEPTION(CfgException, 0, "Unknown preprocessor directive '#", directive.first, "' in ", path, ":",
+                          std::to_string(directive.lineNum + 1).data());
         }
+
+        return {};
     }
 
+    // Start loading of included file unless another include directive already did it
+    auto includeFileTask(const std::shared_ptr<FileLoads>& loads, StrViewCref path) -> std::shared_ptr<FileFuture> {
+#ifndef SCM_NO_THREADS
+        auto lock = std::lock_guard(loads->mutex);
+#endif
+        auto& file = loads->files[String(path)];
+
+        if (!file) {
+            file  = std::make_shared<FileFuture>();
+            // Future keeps the task alive, strong reference to loads would never be released
+            *file = loads->pool.submit([weak = std::weak_ptr(loads), includePath = String(path)] {
+                auto loads = weak.lock();
+                return loads ? loadFileTask(loads, includePath) : nullptr;
+            }).share();
+        }
+
+        return file;
+    }
 
-    void parseLinesTask(StrViewCref path, StrViewVector& lines) {
-        Section* currentSection = nullptr;
+    auto loadFileTask(const std::shared_ptr<FileLoads>& loads, StrViewCref path) -> std::shared_ptr<FileTask> {
+        auto task = std::make_shared<FileTask>(path, loads->mapped);
+        task->tokens = tokenize(task->path, task->file.view());
 
-        for (SizeT n = 0; n < lines.size(); ++n) {
-            auto& line = lines[n];
-            auto  ptr  = line.cbegin();
+        // Start loading of includes, they will be waited for in parseTokensTask
+        for (SizeT i = 0; i < task->tokens.size(); ++i) {
+            auto& tok = task->tokens[i];
 
-            if (skip_spaces_if_no_endl(ptr, line.cend()))
+            if (tok.type != TokenType::Directive)
                 continue;
-            ////////////////////////////////////// Section /////////////////////////////////////////
-            if (*ptr == '[') {
-                auto start = ++ptr;
 
-                ////////////// Read section
+            auto includePath = preprocessorTask(task->path, tok);
+            if (!includePath.empty())
+                task->includes.emplace_back(i, includeFileTask(loads, includePath));
+        }
 
-                SCM_EXCEPTION(CfgException, !is_digit(*ptr) && !is_legal_name_symbol(*ptr),
-                              "Starting section with symbol '", String(1, *ptr), "' in ", path, ":",
-                              std::to_string(n + 1).data());
+        return task;
+    }
 
-                while(*ptr != ']' && ptr != line.cend()) {
+    /**
+     * Add tokens of file and its includes to config data
+     * @param reparse - incremental reload: includes are skipped, file is already in sources
+     * @param units - sections (or GLOBAL_NAMESPACE for global keys) to parse on incremental reload, nullptr for all
+     */
+    void parseTokensTask(CfgData& data, FileTask& task, bool reparse = false, const std::set<StrView>* units = nullptr) {
+        auto& tokens  = task.tokens;
+        auto& graph   = data.graph();
+        auto  include = task.includes.begin();
+        auto  path    = data.intern(task.path);
+        auto  buffer  = String();
+
+        if (!reparse) {
+            auto source = SourceFile{path, task.stamp, {}};
+            task.merging = true;
+
+            for (auto& tok : tokens)
+                if (tok.type == TokenType::Directive)
+                    source.directives.push_back(data.store(tok.second));
+
+            data.addSource(std::move(source));
+        }
 
-                    SCM_EXCEPTION(CfgException, validate_name_symbol(*ptr),
-                                  "Invalid character '", String(1, *ptr), "' in section definition in ", path, ":",
-                                  std::to_string(n + 1).data());
+        Section*       currentSection = nullptr;
+        StrViewVector* globalKeys     = nullptr;
+        bool           skip           = units && units->count(GLOBAL_NAMESPACE) == 0;
 
-                    ++ptr;
-                }
+        for (SizeT i = 0; i < tokens.size(); ++i) {
+            auto& tok = tokens[i];
 
-                SCM_EXCEPTION(CfgException, *ptr == ']', "Missing close section bracket in ", path, ":",
-                              std::to_string(n + 1).data());
+            if (tok.type == TokenType::Section)
+                skip = units && units->count(tok.first) == 0;
 
-                currentSection = &cfg_data().addSection(String(path), n, String(line.substr(start - line.cbegin(), ptr - start)));
+            if (skip)
+                continue;
 
-                ++ptr; // skip ']'
+            switch (tok.type) {
+                case TokenType::Section:
+                    currentSection = &data.addSection(path, tok.lineNum, tok.first);
+                    graph.addUnit(Unit(path, currentSection->name()));
+                    break;
 
-                if (skip_spaces_if_no_endl(ptr, line.cend()))
-                    continue;
+                case TokenType::Parent:
+                    currentSection->addParent(data.intern(tok.first));
+                    break;
 
+                case TokenType::Directive:
+                    if (!reparse && include != task.includes.end() && include->first == i) {
+                        auto& included = *(include++)->second.lock()->get();
+                        auto& sources  = data.sources();
 
-                /////////////// Read parents
+                        SCM_EXCEPTION(CfgException, !included.merging, "Recursive include of '", included.path, "' in ",
+                                      task.path, ":", std::to_string(tok.lineNum + 1).data());
 
-                SCM_EXCEPTION(CfgException, *ptr == ':',
-                              "Unexpected symbol '", String(1, *ptr), "' after section [", currentSection->name(),
-                              "] definition in ", path, ":", std::to_string(n + 1).data());
+                        // File included several times is merged only at its first include
+                        if (std::none_of(sources.begin(), sources.end(), [&](auto& s) { return s.path == included.path; }))
+                            parseTokensTask(data, included);
+                    }
+                    break;
+
+                case TokenType::Key: {
+                    if (currentSection) {
+                        // First definition of duplicate key is kept
+                        if (currentSection->isExists(tok.first)) {
+                            while (i + 1 < tokens.size() &&
+                                   (tokens[i + 1].type == TokenType::Literal || tokens[i + 1].type == TokenType::Reference))
+                                ++i;
+                            break;
+                        }
 
-                SCM_EXCEPTION(CfgException, currentSection->name() != GLOBAL_NAMESPACE,
-                             "Attempt to define parents for global section in ", path, ":", std::to_string(n + 1));
+                        auto key = data.intern(tok.first);
+                        currentSection->add(key, joinValue(data, path, tokens, i, *currentSection, key, buffer));
+                    }
+                    else {
+                        auto& global = data.section(GLOBAL_NAMESPACE);
 
-                ++ptr; // skip ':'
+                        SCM_EXCEPTION(CfgException, !global.isExists(tok.first),
+                                      "Duplicate variable '", tok.first, "' in global namespace in ", path, ":",
+                                      std::to_string(tok.lineNum + 1).data());
 
-                SCM_EXCEPTION(CfgException, !skip_spaces_if_no_endl(ptr, line.cend()),
-                              "Missing parents sections after ':' in ", path, ":",
-                              std::to_string(n + 1).data());
+                        if (!globalKeys)
+                            globalKeys = &graph.globalKeys(path);
 
-                while(ptr != line.end()) {
-                    auto start2 = ptr;
+                        auto key = data.intern(tok.first);
+                        global.add(key, joinValue(data, path, tokens, i, global, key, buffer));
+                        globalKeys->push_back(key);
+                    }
+                } break;
 
-                    SCM_EXCEPTION(CfgException, !is_digit(*ptr) && !is_legal_name_symbol(*ptr),
-                                  "Starting parent definition with symbol '", String(1, *ptr), "' in ", path, ":",
-                                  std::to_string(n + 1).data());
+                default:
+                    break;
+            }
+        }
 
-                    while(!is_space(*ptr) && ptr != line.cend() && *ptr != ',') {
-                        SCM_EXCEPTION(CfgException, validate_name_symbol(*ptr),
-                                      "Invalid character '", String(1, *ptr), "' in parent definition in ", path, ":",
-                                      std::to_string(n + 1).data());
+        task.merging = false;
+    }
 
-                        ++ptr;
-                    }
+    auto nextElement(StrViewCref name, StrViewCref section, StrViewCref str, SizeT& pos) -> StrView
+    {
+        auto ptr = str.cbegin() + pos;
+        auto res = StrView();
 
-                    currentSection->addParent(
-                            String(line.substr(start2 - line.cbegin(), ptr - start2)));
+        if (*ptr == '{') {
+            int entryLevel = 0;
+            auto start = ptr;
 
-                    if (skip_spaces_if_no_endl(ptr, line.cend()))
-                        break;
+            bool onSingleQuotes = false;
+            bool onDoubleQuotes = false;
 
-                    SCM_EXCEPTION(CfgException, *ptr == ',', "Missing ',' after parent definition in ", path, ":",
-                                  std::to_string(n + 1).data());
+            for (; ptr != str.cend(); ++ptr) {
+                if (*ptr == '\'' && !onDoubleQuotes)
+                    onSingleQuotes = !onSingleQuotes;
 
-                    ++ptr;
+                else if (*ptr == '\"' && !onSingleQuotes)
+                    onDoubleQuotes = !onDoubleQuotes;
+
+                else if (!onSingleQuotes && !onDoubleQuotes) {
+                    if (*ptr == '{') {
+                        ++entryLevel;
+                    } else if (*ptr == '}') {
+                        --entryLevel;
+
+                        if (entryLevel == 0) {
+                            if (ptr + 1 != str.cend()) {
+                                SCM_EXCEPTION(CfgException, *(ptr + 1) != '}',
+                                              "Redundant '}' at key '", name, "' in section [", section, "].");
+
+                                SCM_EXCEPTION(CfgException, *(ptr + 1) == ',',
+                                              "Missing ',' at key '", name, "' in section [", section, "].");
+                            }
 
-                    SCM_EXCEPTION(CfgException, !skip_spaces_if_no_endl(ptr, line.cend()),
-                                  "Missing parent parent definition after ',' in ", path, ":",
-                                  std::to_string(n + 1).data());
+                            break;
+                        }
+                    }
                 }
             }
 
-                //////////////////////////// Preprocessor task //////////////////////////////////////
-            else if (*ptr == '#') {
-                preprocessorTask(path, n, line.substr(ptr - line.begin()));
-            }
+            SCM_EXCEPTION(CfgException, entryLevel == 0,
+                          "Missing close '}' at key '", name, "' in section [", section, "].");
 
-                //////////////////////////////// Read variables /////////////////////////////////////
-            else {
-                auto pair = pairFromLine(path, n, line);
+            if (*ptr == '}' && ptr != str.cend())
+                ++ptr;
+
+            res = str.substr(start - str.cbegin(), ptr - start);
+        }
+        else {
+            auto start = ptr;
+
+            bool onSingleQuotes = false;
+            bool onDoubleQuotes = false;
+
+            for (; ptr != str.cend(); ++ptr) {
+                if (*ptr == '\'' && !onDoubleQuotes)
+                    onSingleQuotes = !onSingleQuotes;
 
-                auto var  = unpackVariable(path, n, pair.second, currentSection);
+                else if (*ptr == '\"' && !onSingleQuotes)
+                    onDoubleQuotes = !onDoubleQuotes;
 
-                if (currentSection)
-                    currentSection->add(String(pair.first), var);
-                else {
-                    SCM_EXCEPTION(CfgException,
-                                  !cfg_data().section(String(GLOBAL_NAMESPACE)).isExists(String(pair.first)),
-                                  "Duplicate variable '", pair.first, "' in global namespace in ", path, ":",
-                                  std::to_string(n + 1).data());
+                else if (!onSingleQuotes && !onDoubleQuotes) {
+                    if (*ptr == ',')
+                        break;
 
-                    cfg_data().addValue(String(GLOBAL_NAMESPACE), String(pair.first), var);
+                    SCM_EXCEPTION(CfgException, validate_keyval(*ptr),
+                                  "Undefined char symbol '", String(1, *ptr), "' at key '", name,
+                                  "' in section [", section, "].");
                 }
             }
+
+            res = str.substr(start - str.cbegin(), ptr - start);
         }
-    }
 
+        if (ptr != str.cend())
+            ++ptr;
+
+        pos = static_cast<SizeT>(ptr - str.cbegin());
+
+        return res;
+    }
 
     auto unpack(StrViewCref name, StrViewCref section, StrViewCref str, SizeT required) -> StrViewVector
     {
         StrViewVector vec;
 
-        auto ptr   = str.cbegin();
+        unpackEach(name, section, str, required, [&](StrViewCref elem) { vec.emplace_back(elem); });
 
-        while (ptr != str.cend()) {
-            if (*ptr == '{') {
-                int entryLevel = 0;
-                auto start = ptr;
+        return vec;
+    }
+
+    void processFileTask(CfgData& data, TaskPool& pool, StrViewCref path, bool mapped = true) {
+        auto loads   = std::make_shared<FileLoads>(pool, mapped);
+        auto promise = std::promise<std::shared_ptr<FileTask>>();
 
-                bool onSingleQuotes = false;
-                bool onDoubleQuotes = false;
+        // Root is loaded in place, an include of it gets the same task and is reported as recursive
+        loads->files.emplace(String(path), std::make_shared<FileFuture>(promise.get_future().share()));
 
-                for (; ptr != str.cend(); ++ptr) {
-                    if (*ptr == '\'' && !onDoubleQuotes)
-                        onSingleQuotes = !onSingleQuotes;
+        auto root = loadFileTask(loads, path);
+        promise.set_value(root);
 
-                    else if (*ptr == '\"' && !onSingleQuotes)
-                        onDoubleQuotes = !onDoubleQuotes;
+        parseTokensTask(data, *root);
+    }
 
-                    else if (!onSingleQuotes && !onDoubleQuotes) {
-                        if (*ptr == '{') {
-                            ++entryLevel;
-                        } else if (*ptr == '}') {
-                            --entryLevel;
+    void Value::preparse() {
+        auto ptr = _text.data();
+        auto end = ptr + _text.size();
 
-                            if (entryLevel == 0) {
-                                if (ptr + 1 != str.cend()) {
-                                    SCM_EXCEPTION(CfgException, *(ptr + 1) != '}',
-                                                  "Redundant '}' at key '", name, "' in section [", section, "].");
+        _type = ValueType::String;
 
-                                    SCM_EXCEPTION(CfgException, *(ptr + 1) == ',',
-                                                  "Missing ',' at key '", name, "' in section [", section, "].");
-                                }
+        if (_text == "true" || _text == "on" || _text == "false" || _text == "off") {
+            _type    = ValueType::Bool;
+            _integer = _text == "true" || _text == "on";
+            return;
+        }
 
-                                break;
-                            }
-                        }
-                    }
-                }
+        if (ptr != end && (*ptr == '{' || std::find(ptr, end, ',') != end)) {
+            _type = ValueType::List;
+            return;
+        }
+
+        // [+-]digits[.digits][(e|E)[+-]digits]
+        auto neg = ptr != end && *ptr == '-';
+
+        if (ptr != end && (*ptr == '-' || *ptr == '+'))
+            ++ptr;
+
+        auto digits = ptr;
+        while (ptr != end && is_digit(*ptr))
+            ++ptr;
 
-                SCM_EXCEPTION(CfgException, entryLevel == 0,
-                              "Missing close '}' at key '", name, "' in section [", section, "].");
+        if (ptr == digits)
+            return;
 
-                if (*ptr == '}' && ptr != str.cend())
+        if (ptr == end) {
+            // Leave long integers and '-0' to text conversion
+            if (ptr - digits > 18)
+                return;
+
+            auto value = SCM_NAMESPACE::aton<std::int64_t>(_text, "", "");
+
+            if (!(value == 0 && neg)) {
+                _type    = ValueType::Int;
+                _integer = value;
+                return;
+            }
+        }
+        else {
+            if (*ptr == '.') {
+                ++ptr;
+                while (ptr != end && is_digit(*ptr))
                     ++ptr;
+            }
 
+            if (ptr != end && (*ptr == 'e' || *ptr == 'E')) {
+                ++ptr;
 
-                vec.emplace_back(str.substr(start - str.cbegin(), ptr - start));
+                if (ptr != end && (*ptr == '-' || *ptr == '+'))
+                    ++ptr;
 
-                if (ptr != str.cend())
+                auto exp = ptr;
+                while (ptr != end && is_digit(*ptr))
                     ++ptr;
 
+                if (ptr == exp)
+                    return;
             }
-            else {
-                auto start = ptr;
 
-                bool onSingleQuotes = false;
-                bool onDoubleQuotes = false;
+            if (ptr != end)
+                return;
+        }
 
-                for (; ptr != str.cend(); ++ptr) {
-                    if (*ptr == '\'' && !onDoubleQuotes)
-                        onSingleQuotes = !onSingleQuotes;
+        _type   = ValueType::Float;
+        _real   = SCM_NAMESPACE::aton<double>(_text, "", "");
+        _real32 = SCM_NAMESPACE::aton<float>(_text, "", "");
+    }
 
-                    else if (*ptr == '\"' && !onSingleQuotes)
-                        onDoubleQuotes = !onDoubleQuotes;
+    /**
+     * Compiled cache layout (native byte order, strings are u64 size + chars):
+     *   "SCMC" u32 version, u32 byte order mark, u32 reserved, u64 file size
+     *   str root
+     *   u64 count, {str path, u64 size, i64 mtime} - all loaded files
+     *   u64 count, {str name, str file, u64 count, {str parent},
+     *               u64 count, {str key, str text, u8 type, f32 real32, u64 payload}} - sections
+     * Loaded strings are views into the mapped file
+     */
+    constexpr char          CACHE_MAGIC[4]   = {'S', 'C', 'M', 'C'};
+    constexpr std::uint32_t CACHE_VERSION    = 1;
+    constexpr std::uint32_t CACHE_BYTE_ORDER = 0x01020304;
+
+    class CacheWriter {
+    public:
+        template <typename T>
+        void put(const T& val) {
+            _data.append(reinterpret_cast<const char*>(&val), sizeof(T));
+        }
 
-                    else if (!onSingleQuotes && !onDoubleQuotes) {
-                        if (*ptr == ',')
-                            break;
+        void putStr(StrViewCref str) {
+            put(static_cast<std::uint64_t>(str.size()));
+            _data.append(str.data(), str.size());
+        }
 
-                        SCM_EXCEPTION(CfgException, validate_keyval(*ptr),
-                                      "Undefined char symbol '", String(1, *ptr), "' at key '", name,
-                                      "' in section [", section, "].");
-                    }
-                }
+        auto data() -> String& { return _data; }
 
-                vec.emplace_back(str.substr(start - str.cbegin(), ptr - start));
+    private:
+        String _data;
+    };
 
-                if (ptr != str.cend())
-                    ++ptr;
+    class CacheReader {
+    public:
+        explicit CacheReader(StrViewCref data): _data(data) {}
+
+        template <typename T>
+        bool get(T& val) {
+            if (_data.size() - _pos < sizeof(T))
+                return false;
+
+            std::memcpy(&val, _data.data() + _pos, sizeof(T));
+            _pos += sizeof(T);
+
+            return true;
+        }
+
+        bool getStr(StrView& str) {
+            std::uint64_t size = 0;
+
+            if (!get(size) || _data.size() - _pos < size)
+                return false;
+
+            str   = _data.substr(_pos, static_cast<SizeT>(size));
+            _pos += static_cast<SizeT>(size);
+
+            return true;
+        }
+
+    private:
+        StrView _data;
+        SizeT   _pos = 0;
+    };
+
+    void saveCache(const CfgData& data, StrViewCref path) {
+        SCM_EXCEPTION(CfgException, data.roots().size() == 1 && data.roots().front() == path,
+                      "Can't save compiled cache of '", path, "'. Data must be parsed from this file only");
+
+        auto out = CacheWriter();
+
+        out.data().append(CACHE_MAGIC, sizeof(CACHE_MAGIC));
+        out.put(CACHE_VERSION);
+        out.put(CACHE_BYTE_ORDER);
+        out.put(std::uint32_t(0));
+        out.put(std::uint64_t(0)); // File size, written at the end
+
+        out.putStr(path);
+
+        out.put(static_cast<std::uint64_t>(data.sources().size()));
+        for (auto& source : data.sources()) {
+            out.putStr(source.path);
+            out.put(source.stamp.size);
+            out.put(source.stamp.mtime);
+        }
+
+        out.put(static_cast<std::uint64_t>(data.getSections().size()));
+        for (auto& [name, sectPtr] : data.getSections()) {
+            auto& sect = *sectPtr;
+
+            out.putStr(name);
+            out.putStr(sect.file());
+
+            out.put(static_cast<std::uint64_t>(sect.getParents().size()));
+            for (auto& parent : sect.getParents())
+                out.putStr(parent);
+
+            out.put(static_cast<std::uint64_t>(sect.getMap().size()));
+            for (auto& [key, val] : sect.getMap()) {
+                out.putStr(key);
+                out.putStr(val.text());
+                out.put(static_cast<std::uint8_t>(val.type()));
+                out.put(val.real32());
+                out.put(val.payload());
+            }
+        }
+
+        auto size = static_cast<std::uint64_t>(out.data().size());
+        std::memcpy(out.data().data() + 16, &size, sizeof(size));
+
+        // Write to temporary file and rename it, so the cache is never seen half-written
+        auto cache = cachePath(path);
+        auto temp  = cache + ".tmp";
+        {
+            auto ofs = std::ofstream(temp.data(), std::ios_base::binary | std::ios_base::out | std::ios_base::trunc);
+            SCM_EXCEPTION(SCM_NAMESPACE::ScmIfsException, ofs.is_open(), "Can't open file: '", temp, "'");
+
+            ofs.write(out.data().data(), static_cast<std::streamsize>(out.data().size()));
+            SCM_EXCEPTION(SCM_NAMESPACE::ScmIfsException, ofs.good(), "Can't write file: '", temp, "'");
+        }
+
+        // Rename doesn't replace existing file on Windows
+        if (std::rename(temp.data(), cache.data()) != 0) {
+            std::remove(cache.data());
+
+            auto renamed = std::rename(temp.data(), cache.data()) == 0;
+            SCM_EXCEPTION(SCM_NAMESPACE::ScmIfsException, renamed, "Can't write file: '", cache, "'");
+        }
+    }
+
+    /**
+     * Read sections from compiled cache to cfg data
+     * @return false if cache is corrupted
+     */
+    bool loadCacheSections(CfgData& data, CacheReader& in) {
+        std::uint64_t sectCount = 0;
+        if (!in.get(sectCount))
+            return false;
+
+        for (std::uint64_t i = 0; i < sectCount; ++i) {
+            StrView       name, file, parent;
+            std::uint64_t count = 0;
+
+            if (!in.getStr(name) || !in.getStr(file) || !in.get(count))
+                return false;
+
+            auto& sect = data.section(name);
+            sect.file() = file;
+
+            for (std::uint64_t j = 0; j < count; ++j) {
+                if (!in.getStr(parent))
+                    return false;
+                sect.addParent(parent);
+            }
+
+            if (!in.get(count))
+                return false;
+
+            for (std::uint64_t j = 0; j < count; ++j) {
+                StrView       key, text;
+                std::uint8_t  type    = 0;
+                float         real32  = 0;
+                std::uint64_t payload = 0;
+
+                if (!in.getStr(key) || !in.getStr(text) || !in.get(type) || !in.get(real32) || !in.get(payload) ||
+                    type > static_cast<std::uint8_t>(ValueType::List))
+                    return false;
+
+                sect.add(key, Value(text, static_cast<ValueType>(type), payload, real32));
             }
         }
 
-        if (vec.size() == 1 && vec[0].size() > 1 && vec[0].front() == '{' && vec[0].back() == '}')
-            return unpack(name, section, vec[0].substr(1, vec[0].size() - 2), required);
+        return true;
+    }
+
+    bool loadCache(CfgData& data, StrViewCref path) {
+        auto cache = cachePath(path);
+
+        if (!fileStamp(cache))
+            return false;
+
+        auto file = std::make_unique<SCM_NAMESPACE::file_view>(cache);
+        auto in   = CacheReader(file->view());
+
+        char          magic[4] = {};
+        std::uint32_t version = 0, byteOrder = 0, reserved = 0;
+        std::uint64_t size = 0, count = 0;
+        StrView       root;
+
+        if (!in.get(magic) || std::memcmp(magic, CACHE_MAGIC, sizeof(magic)) != 0 ||
+            !in.get(version) || version != CACHE_VERSION || !in.get(byteOrder) || byteOrder != CACHE_BYTE_ORDER ||
+            !in.get(reserved) || !in.get(size) || size > file->view().size() ||
+            !in.getStr(root) || root != path || !in.get(count))
+            return false;
+
+        // Every loaded file must be unchanged
+        auto sources = ScmVector<SourceFile>();
+
+        for (std::uint64_t i = 0; i < count; ++i) {
+            StrView   source;
+            FileStamp stamp;
+
+            if (!in.getStr(source) || !in.get(stamp.size) || !in.get(stamp.mtime))
+                return false;
+
+            auto current = fileStamp(source);
+            if (!current || *current != stamp)
+                return false;
+
+            sources.push_back(SourceFile{source, stamp, {}});
+        }
+
+        if (!loadCacheSections(data, in)) {
+            data.clear();
+            return false;
+        }
+
+        data.addRoot(path);
+        for (auto& source : sources)
+            data.addSource(std::move(source));
+
+        // Cache doesn't store dependencies, so next reload parses everything
+        data.graph().complete(false);
+
+        // Mapping stays valid: saveCache replaces cache by rename and never truncates it
+        data.keepFile(std::move(file));
+
+        return true;
+    }
+
+    void parse(CfgData& data, StrViewCref path, bool preparse, bool mapped) {
+        auto pool = TaskPool();
+
+        if (data.empty() && loadCache(data, path)) {
+            if (preparse)
+                data.preparseValues(pool);
+
+            data.preparsed(preparse);
+            data.linkParents(pool);
+            data.nextGeneration();
+            return;
+        }
+
+        data.addRoot(path);
+        processFileTask(data, pool, path, mapped);
+        resolveReferences(data, pool);
 
-        SCM_EXCEPTION(CfgException, required == 0 || required == vec.size(),
-                      "Wrong number of values at key '", name, "' in section [", section, "]. Provided ",
-                      std::to_string(vec.size()).data(), ", required ", std::to_string(required).data(), ".");
+        if (preparse)
+            data.preparseValues(pool);
 
-        return std::move(vec);
+        data.preparsed(preparse);
+        data.linkParents(pool);
+        data.nextGeneration();
     }
 
-    void processFileTask(StrViewCref path) {
-        auto file  = SCM_NAMESPACE::read_file_to_string(path);
-        auto lines = SCM_NAMESPACE::split_view(file, {'\n', '\r', '\0'}, true); // do not delete empty strings
+    auto directivesOf(const FileTask& task) -> StrViewVector {
+        auto res = StrViewVector();
+
+        for (auto& tok : task.tokens)
+            if (tok.type == TokenType::Directive)
+                res.push_back(tok.second);
 
-        deleteComments(path, lines);
-        parseLinesTask(path, lines);
+        return res;
     }
 
-    void parse(StrViewCref path) {
-        processFileTask(path);
-        cfg_data().reloadParents();
+    bool sourcesChanged(const CfgData& data) {
+        for (auto& source : data.sources()) {
+            auto stamp = fileStamp(source.path);
+
+            if (!stamp || *stamp != source.stamp)
+                return true;
+        }
+
+        return false;
+    }
+
+    bool reloadChanged(CfgData& data, bool preparse) {
+        // Graph is shared with data which is being read, it is copied only when something must be parsed
+        if (!std::as_const(data).graph().complete())
+            return false;
+
+        auto changed   = ScmVector<std::unique_ptr<FileTask>>();
+        auto paths     = StrViewVector();
+        auto totalSize = SizeT(0);
+
+        for (auto& source : data.sources()) {
+            auto stamp = fileStamp(source.path);
+
+            if (!stamp)
+                return false;
+
+            totalSize += static_cast<SizeT>(stamp->size);
+
+            if (*stamp == source.stamp)
+                continue;
+
+            // Changed files may be still written, so they are read into buffers
+            auto task = std::make_unique<FileTask>(source.path, false);
+            task->tokens = tokenize(task->path, task->file.view());
+
+            // Other includes change what is parsed and in which order
+            if (directivesOf(*task) != source.directives)
+                return false;
+
+            paths.push_back(source.path);
+            changed.push_back(std::move(task));
+        }
+
+        if (changed.empty()) {
+            if (preparse && !data.preparsed()) {
+                auto pool = TaskPool();
+                data.preparseValues(pool);
+                data.preparsed(true);
+            }
+            return true;
+        }
+
+        auto& graph     = data.graph();
+        auto  affected  = graph.affected(paths);
+        auto  fileUnits = std::map<StrView, std::set<StrView>>();
+
+        for (auto& unit : affected)
+            fileUnits[unit.first].insert(unit.second);
+
+        // Strings of parsed again units stay in arena. Parse from scratch when they would be twice bigger than config
+        auto reparsedSize = SizeT(0);
+
+        for (auto& source : data.sources())
+            if (fileUnits.count(source.path))
+                reparsedSize += static_cast<SizeT>(source.stamp.size);
+
+        if (data.reparsedSize() + reparsedSize > totalSize * 2)
+            return false;
+
+        // Data is consistent again only when all units are parsed
+        graph.complete(false);
+
+        for (auto& unit : affected)
+            data.removeUnit(unit);
+
+        for (auto& source : data.sources()) {
+            auto task = std::find_if(changed.begin(), changed.end(), [&](auto& t) { return t->path == source.path; });
+
+            if (task != changed.end()) {
+                parseTokensTask(data, **task, true);
+                continue;
+            }
+
+            auto units = fileUnits.find(source.path);
+            if (units == fileUnits.end())
+                continue;
+
+            auto other = FileTask(source.path, false);
+            other.tokens = tokenize(other.path, other.file.view());
+
+            parseTokensTask(data, other, true, &units->second);
+        }
+
+        auto pool = TaskPool();
+        resolveReferences(data, pool);
+
+        // Classify new values only in parsed sections
+        auto parsed = std::set<StrView>();
+
+        for (auto& unit : affected)
+            parsed.insert(unit.second);
+
+        for (auto& path : paths)
+            for (auto& sect : graph.units(path))
+                parsed.insert(sect);
+
+
+        if (preparse && data.preparsed()) {
+            for (auto& name : parsed) {
+                auto sect = data.findSection(name);
+                if (sect)
+                    sect->preparse();
+            }
+        }
+        else if (preparse) {
+            data.preparseValues(pool);
+        }
+
+        // Parsed sections are new, so only they are linked
+        data.linkParents(pool);
+
+        data.preparsed(preparse);
+
+        for (auto& task : changed)
+            for (auto& source : data.sources())
+                if (source.path == task->path)
+                    source.stamp = task->stamp;
+
+        data.addReparsedSize(reparsedSize);
+        graph.complete(true);
+        data.nextGeneration();
+
+        return true;
     }
 
 } // namespace scm_details
\ No newline at end of file
@@ -63,6 +63,18 @@ int scm_fs_dtls::_recursiveMakeDir(const std::string_view& path) {
 }
 
 
+bool scm_fs_dtls::_fileStamp(const std::string_view& path, std::uint64_t& size, std::int64_t& mtime) {
+    struct stat st = {};
+
+    if (stat(std::string(path).c_str(), &st) == -1)
+        return false;
+
+    size  = static_cast<std::uint64_t>(st.st_size);
+    mtime = static_cast<std::int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+
+    return true;
+}
+
 auto scm_fs_dtls::_getExeLocation() -> std::string {
     auto result = std::array<char, DE_PATH_MAX>();
     auto count  = readlink( "/proc/self/exe", result.data(), DE_PATH_MAX);
@@ -163,6 +175,19 @@ int scm_fs_dtls::_recursiveMakeDir(const std::string_view& path) {
 
 }
 
+bool scm_fs_dtls::_fileStamp(const std::string_view& path, std::uint64_t& size, std::int64_t& mtime) {
+    WIN32_FILE_ATTRIBUTE_DATA data;
+
+    if (!GetFileAttributesExA(std::string(path).c_str(), GetFileExInfoStandard, &data))
+        return false;
+
+    size  = (static_cast<std::uint64_t>(data.nFileSizeHigh) << 32) | data.nFileSizeLow;
+    mtime = static_cast<std::int64_t>((static_cast<std::uint64_t>(data.ftLastWriteTime.dwHighDateTime) << 32) |
+                                      data.ftLastWriteTime.dwLowDateTime);
+
+    return true;
+}
+
 auto scm_fs_dtls::_getExeLocation() -> std::string {
     auto result = std::array<wchar_t, DE_PATH_MAX>();
     auto count  = GetModuleFileNameW(nullptr, result.data(), DE_PATH_MAX);
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <exception>
+#include <cstdint>
 
 #include "scm_utils.hpp"
 
@@ -16,6 +17,7 @@ namespace scm_fs_dtls {
     int  _recursiveMakeDir (const std::string_view& path);
     auto _listFiles        (const std::string_view& path) -> std::vector<std::string>;
     auto _listDirs         (const std::string_view& path) -> std::vector<std::string>;
+    bool _fileStamp        (const std::string_view& path, std::uint64_t& size, std::int64_t& mtime);
 
 } // namespace scm_fs_dtls
 
@@ -0,0 +1,525 @@
+#pragma once
+
+#include <new>
+#include <memory>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <iterator>
+#include <algorithm>
+#include <functional>
+#include <string_view>
+#include <type_traits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define SCM_FLAT_MAP_SSE2
+#endif
+
+namespace scm_details {
+
+    /**
+     * Hash of bytes, tuned for short strings: 8 bytes are mixed at a time,
+     * tail is read with overlapping loads instead of byte by byte
+     */
+    inline auto hashBytes(const char* data, std::size_t size) -> std::uint64_t {
+        constexpr std::uint64_t mul = 0x9e3779b97f4a7c15ULL;
+
+        auto load64 = [](const char* ptr) { std::uint64_t word; std::memcpy(&word, ptr, 8); return word; };
+        auto load32 = [](const char* ptr) { std::uint32_t word; std::memcpy(&word, ptr, 4); return std::uint64_t(word); };
+        auto mix    = [&](std::uint64_t hash, std::uint64_t word) {
+            hash = (hash ^ word) * mul;
+            return hash ^ (hash >> 29);
+        };
+
+        auto end  = data + size;
+        auto hash = std::uint64_t(size) * mul;
+
+        if (size >= 8) {
+            for (; end - data > 8; data += 8)
+                hash = mix(hash, load64(data));
+            hash = mix(hash, load64(end - 8));
+        }
+        else if (size >= 4) {
+            hash = mix(hash, load32(data) << 32 | load32(end - 4));
+        }
+        else if (size) {
+            auto byte = [](char c) { return std::uint64_t(static_cast<unsigned char>(c)); };
+            hash = mix(hash, byte(data[0]) << 16 | byte(data[size / 2]) << 8 | byte(end[-1]));
+        }
+
+        hash ^= hash >> 32;
+        hash *= 0xd6e8feb86659fd93ULL;
+        return hash ^ (hash >> 32);
+    }
+
+    /**
+     * Default hash of FlatMap. Strings use hashBytes, other keys use std::hash
+     */
+    template <typename K, typename = void>
+    struct FlatHash : std::hash<K> {};
+
+    template <typename K>
+    struct FlatHash<K, std::enable_if_t<std::is_convertible_v<const K&, std::string_view>>> {
+        auto operator()(const K& key) const -> std::size_t {
+            auto str = std::string_view(key);
+            return static_cast<std::size_t>(hashBytes(str.data(), str.size()));
+        }
+    };
+
+    /**
+     * Open addressing hash map with SwissTable layout. Every slot has control byte: 7 bits of hash if slot is full,
+     * or empty / deleted mark. Lookup compares control bytes of 16 slots at once (with SSE2 if available)
+     * and compares keys only for matching bytes. Entries are stored in one array, without node per entry.
+     * Interface is subset of std::unordered_map. Pointers and iterators are invalidated by insertion of new key
+     * and by rehash, erase invalidates only erased entry
+     */
+    template <typename K, typename V, typename Hash = FlatHash<K>, typename KeyEqual = std::equal_to<K>>
+    class FlatMap {
+    public:
+        using key_type        = K;
+        using mapped_type     = V;
+        using value_type      = std::pair<const K, V>;
+        using size_type       = std::size_t;
+        using difference_type = std::ptrdiff_t;
+        using hasher          = Hash;
+        using key_equal       = KeyEqual;
+        using reference       = value_type&;
+        using const_reference = const value_type&;
+
+    private:
+        static constexpr std::size_t GROUP        = 16;
+        static constexpr std::size_t MIN_CAPACITY = 2;  // Sections often have a couple of keys
+
+        using Ctrl = std::int8_t;
+
+        static constexpr Ctrl EMPTY    = -128;
+        static constexpr Ctrl DELETED  = -2;
+        static constexpr Ctrl SENTINEL = -1;  // Pads control bytes of tables smaller than group
+
+        /**
+         * Control bytes of 16 slots. Masks have bit i set for slot i
+         */
+        class Group {
+        public:
+#ifdef SCM_FLAT_MAP_SSE2
+            explicit Group(const Ctrl* ctrl): _ctrl(_mm_load_si128(reinterpret_cast<const __m128i*>(ctrl))) {}
+
+            auto match(Ctrl h2) const -> std::uint32_t {
+                return static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), _ctrl)));
+            }
+
+            auto matchEmpty() const -> std::uint32_t {
+                return match(EMPTY);
+            }
+
+            // Only empty and deleted bytes are less than sentinel, full bytes hold hash bits 0..127
+            auto matchFree() const -> std::uint32_t {
+                return static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_set1_epi8(SENTINEL), _ctrl)));
+            }
+
+        private:
+            __m128i _ctrl;
+#else
+            explicit Group(const Ctrl* ctrl): _ctrl(ctrl) {}
+
+            auto match(Ctrl h2) const -> std::uint32_t {
+                std::uint32_t mask = 0;
+                for (std::size_t i = 0; i < GROUP; ++i)
+                    mask |= std::uint32_t(_ctrl[i] == h2) << i;
+                return mask;
+            }
+
+            auto matchEmpty() const -> std::uint32_t {
+                return match(EMPTY);
+            }
+
+            auto matchFree() const -> std::uint32_t {
+                std::uint32_t mask = 0;
+                for (std::size_t i = 0; i < GROUP; ++i)
+                    mask |= std::uint32_t(_ctrl[i] < SENTINEL) << i;
+                return mask;
+            }
+
+        private:
+            const Ctrl* _ctrl;
+#endif
+        };
+
+        static auto lowestBit(std::uint32_t mask) -> std::size_t {
+#if defined(__GNUC__) || defined(__clang__)
+            return static_cast<std::size_t>(__builtin_ctz(mask));
+#else
+            std::size_t i = 0;
+            while (!(mask & 1)) {
+                mask >>= 1;
+                ++i;
+            }
+            return i;
+#endif
+        }
+
+        template <bool Const>
+        class Iterator {
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type        = FlatMap::value_type;
+            using difference_type   = std::ptrdiff_t;
+            using pointer           = std::conditional_t<Const, const value_type*, value_type*>;
+            using reference         = std::conditional_t<Const, const value_type&, value_type&>;
+
+            Iterator() = default;
+
+            // Iterator converts to const_iterator
+            template <bool C = Const, typename = std::enable_if_t<C>>
+            Iterator(const Iterator<false>& it): _map(it._map), _index(it._index) {}
+
+            auto operator*  () const -> reference { return _map->_slots[_index]; }
+            auto operator-> () const -> pointer   { return &_map->_slots[_index]; }
+
+            auto operator++ () -> Iterator& {
+                _index = _map->nextFull(_index + 1);
+                return *this;
+            }
+
+            auto operator++ (int) -> Iterator {
+                auto it = *this;
+                ++*this;
+                return it;
+            }
+
+            bool operator== (const Iterator& it) const { return _index == it._index; }
+            bool operator!= (const Iterator& it) const { return _index != it._index; }
+
+        private:
+            friend class FlatMap;
+            friend class Iterator<true>;
+
+            using Map = std::conditional_t<Const, const FlatMap, FlatMap>;
+
+            Iterator(Map* map, std::size_t index): _map(map), _index(index) {}
+
+            Map*        _map   = nullptr;
+            std::size_t _index = 0;
+        };
+
+    public:
+        using iterator       = Iterator<false>;
+        using const_iterator = Iterator<true>;
+
+        FlatMap() = default;
+
+        FlatMap(const FlatMap& map) {
+            if (map._size == 0)
+                return;
+
+            // Same layout, entries are copied in place without rehash
+            allocate(map._capacity);
+            std::memcpy(_ctrl, map._ctrl, ctrlSize(_capacity));
+
+            for (std::size_t i = 0; i < _capacity; ++i)
+                if (_ctrl[i] >= 0)
+                    new (_slots + i) value_type(map._slots[i]);
+
+            _size    = map._size;
+            _deleted = map._deleted;
+        }
+
+        FlatMap(FlatMap&& map) noexcept {
+            swap(map);
+        }
+
+        FlatMap& operator= (const FlatMap& map) {
+            if (this != &map) {
+                auto copy = FlatMap(map);
+                swap(copy);
+            }
+            return *this;
+        }
+
+        FlatMap& operator= (FlatMap&& map) noexcept {
+            swap(map);
+            return *this;
+        }
+
+        ~FlatMap() {
+            destroy();
+            deallocate();
+        }
+
+        void swap(FlatMap& map) noexcept {
+            std::swap(_ctrl,     map._ctrl);
+            std::swap(_slots,    map._slots);
+            std::swap(_capacity, map._capacity);
+            std::swap(_size,     map._size);
+            std::swap(_deleted,  map._deleted);
+        }
+
+        auto begin()        -> iterator       { return iterator(this, nextFull(0)); }
+        auto end()          -> iterator       { return iterator(this, _capacity); }
+        auto begin()  const -> const_iterator { return const_iterator(this, nextFull(0)); }
+        auto end()    const -> const_iterator { return const_iterator(this, _capacity); }
+        auto cbegin() const -> const_iterator { return begin(); }
+        auto cend()   const -> const_iterator { return end(); }
+
+        auto size()  const -> size_type { return _size; }
+        bool empty() const              { return _size == 0; }
+
+        auto find(const K& key) -> iterator {
+            return iterator(this, findIndex(key));
+        }
+
+        auto find(const K& key) const -> const_iterator {
+            return const_iterator(this, findIndex(key));
+        }
+
+        auto count(const K& key) const -> size_type {
+            return findIndex(key) != _capacity;
+        }
+
+        /**
+         * Insert value constructed from args if key doesn't exist
+         * @return Iterator to entry with the key and true if it was inserted
+         */
+        template <typename... Args>
+        auto try_emplace(const K& key, Args&&... args) -> std::pair<iterator, bool> {
+            auto hash  = static_cast<std::size_t>(_hash(key));
+            auto index = findIndex(key, hash);
+
+            if (index != _capacity)
+                return {iterator(this, index), false};
+
+            index = prepareInsert(hash);
+            new (_slots + index) value_type(std::piecewise_construct, std::forward_as_tuple(key),
+                                            std::forward_as_tuple(std::forward<Args>(args)...));
+
+            // Slot is marked full only after entry is constructed
+            if (_ctrl[index] == DELETED)
+                --_deleted;
+
+            _ctrl[index] = h2(hash);
+            ++_size;
+
+            return {iterator(this, index), true};
+        }
+
+        template <typename KK, typename VV>
+        auto emplace(KK&& key, VV&& value) -> std::pair<iterator, bool> {
+            return try_emplace(K(std::forward<KK>(key)), std::forward<VV>(value));
+        }
+
+        auto insert(const value_type& value) -> std::pair<iterator, bool> {
+            return try_emplace(value.first, value.second);
+        }
+
+        auto operator[] (const K& key) -> V& {
+            return try_emplace(key).first->second;
+        }
+
+        auto erase(const_iterator pos) -> iterator {
+            auto index = pos._index;
+
+            _slots[index].~value_type();
+            --_size;
+
+            // Probes stop at group with empty byte. If the group has one, no probe has passed it while it was full
+            if (Group(_ctrl + index / GROUP * GROUP).matchEmpty()) {
+                _ctrl[index] = EMPTY;
+            } else {
+                _ctrl[index] = DELETED;
+                ++_deleted;
+            }
+
+            return iterator(this, nextFull(index + 1));
+        }
+
+        auto erase(iterator pos) -> iterator {
+            return erase(const_iterator(pos));
+        }
+
+        auto erase(const K& key) -> size_type {
+            auto index = findIndex(key);
+
+            if (index == _capacity)
+                return 0;
+
+            erase(const_iterator(this, index));
+            return 1;
+        }
+
+        /**
+         * Remove all entries, capacity is kept
+         */
+        void clear() {
+            destroy();
+
+            if (_capacity)
+                std::memset(_ctrl, EMPTY, _capacity);
+
+            _size    = 0;
+            _deleted = 0;
+        }
+
+        void reserve(size_type count) {
+            auto capacity = capacityFor(count);
+
+            if (capacity > _capacity)
+                rehash(capacity);
+        }
+
+    private:
+        static auto h1(std::size_t hash) -> std::size_t { return hash >> 7; }
+        static auto h2(std::size_t hash) -> Ctrl        { return static_cast<Ctrl>(hash & 0x7f); }
+
+        // Load factor is at most 7/8. Tables smaller than group keep one empty slot, so probes stop
+        static auto growthLimit(std::size_t capacity) -> std::size_t {
+            if (capacity < GROUP)
+                return capacity ? capacity - 1 : 0;
+
+            return capacity - capacity / 8;
+        }
+
+        static auto capacityFor(std::size_t count) -> std::size_t {
+            auto capacity = MIN_CAPACITY;
+            while (growthLimit(capacity) < count)
+                capacity *= 2;
+            return capacity;
+        }
+
+        auto findIndex(const K& key) const -> std::size_t {
+            return _size ? findIndex(key, static_cast<std::size_t>(_hash(key))) : _capacity;
+        }
+
+        /**
+         * Groups are probed in triangular sequence, which visits all of them because their count is power of 2
+         * @return Index of entry with the key or capacity if it doesn't exist
+         */
+        auto findIndex(const K& key, std::size_t hash) const -> std::size_t {
+            if (_capacity == 0)
+                return 0;
+
+            auto mask  = (_capacity + GROUP - 1) / GROUP - 1;
+            auto group = h1(hash) & mask;
+
+            for (std::size_t step = 1;; ++step) {
+                auto ctrl = _ctrl + group * GROUP;
+                auto grp  = Group(ctrl);
+
+                for (auto match = grp.match(h2(hash)); match; match &= match - 1) {
+                    auto index = group * GROUP + lowestBit(match);
+                    if (_equal(_slots[index].first, key))
+                        return index;
+                }
+
+                if (grp.matchEmpty())
+                    return _capacity;
+
+                group = (group + step) & mask;
+            }
+        }
+
+        /**
+         * Find free slot for new key. Table grows if it is full enough, or drops deleted marks
+         * if most of them are deleted
+         * @return Index of the slot
+         */
+        auto prepareInsert(std::size_t hash) -> std::size_t {
+            if (_size + _deleted >= growthLimit(_capacity))
+                rehash(_size * 2 >= growthLimit(_capacity) ? std::max(_capacity * 2, MIN_CAPACITY) : _capacity);
+
+            return findFree(hash);
+        }
+
+        auto findFree(std::size_t hash) const -> std::size_t {
+            auto mask  = (_capacity + GROUP - 1) / GROUP - 1;
+            auto group = h1(hash) & mask;
+
+            for (std::size_t step = 1;; ++step) {
+                auto free = Group(_ctrl + group * GROUP).matchFree();
+
+                if (free)
+                    return group * GROUP + lowestBit(free);
+
+                group = (group + step) & mask;
+            }
+        }
+
+        /**
+         * Move entries to new table. Also drops deleted marks if capacity isn't changed
+         */
+        void rehash(std::size_t capacity) {
+            auto ctrl     = _ctrl;
+            auto slots    = _slots;
+            auto previous = _capacity;
+
+            allocate(capacity);
+            _deleted = 0;
+
+            for (std::size_t i = 0; i < previous; ++i) {
+                if (ctrl[i] < 0)
+                    continue;
+
+                auto hash  = static_cast<std::size_t>(_hash(slots[i].first));
+                auto index = findFree(hash);
+
+                _ctrl[index] = h2(hash);
+                new (_slots + index) value_type(std::move(slots[i]));
+                slots[i].~value_type();
+            }
+
+            deallocate(ctrl, previous);
+        }
+
+        auto nextFull(std::size_t index) const -> std::size_t {
+            while (index < _capacity && _ctrl[index] < 0)
+                ++index;
+            return index;
+        }
+
+        // Groups are loaded with aligned loads
+        static constexpr std::size_t ALIGN = std::max(GROUP, alignof(value_type));
+
+        // Control bytes fill whole groups, slots follow them in the same block
+        static auto ctrlSize(std::size_t capacity) -> std::size_t {
+            return (std::max(capacity, GROUP) + ALIGN - 1) / ALIGN * ALIGN;
+        }
+
+        void allocate(std::size_t capacity) {
+            auto size  = ctrlSize(capacity);
+            auto block = static_cast<char*>(::operator new(size + capacity * sizeof(value_type), std::align_val_t(ALIGN)));
+
+            _ctrl     = reinterpret_cast<Ctrl*>(block);
+            _slots    = reinterpret_cast<value_type*>(block + size);
+            _capacity = capacity;
+
+            std::memset(_ctrl, EMPTY, capacity);
+            std::memset(_ctrl + capacity, SENTINEL, size - capacity);
+        }
+
+        void deallocate() {
+            deallocate(_ctrl, _capacity);
+        }
+
+        static void deallocate(Ctrl* ctrl, std::size_t capacity) {
+            if (capacity)
+                ::operator delete(ctrl, std::align_val_t(ALIGN));
+        }
+
+        void destroy() {
+            if constexpr (!std::is_trivially_destructible_v<value_type>)
+                for (std::size_t i = 0; i < _capacity; ++i)
+                    if (_ctrl[i] >= 0)
+                        _slots[i].~value_type();
+        }
+
+        Ctrl*        _ctrl     = nullptr;
+        value_type*  _slots    = nullptr;
+        std::size_t  _capacity = 0;
+        std::size_t  _size     = 0;
+        std::size_t  _deleted  = 0;
+
+        Hash         _hash;
+        KeyEqual     _equal;
+    };
+
+} // namespace scm_details
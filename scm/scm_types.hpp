@@ -54,7 +54,7 @@ using ScmChar8 = char;
     template <typename K, typename V>
     using ScmMap = SCM_TYPE_MAP<K, V>;
 #else
-    #include <unordered_map>
+    #include "scm_flat_map.hpp"
     template <typename K, typename V>
-    using ScmMap = std::unordered_map<K, V>;
+    using ScmMap = scm_details::FlatMap<K, V>;
 #endif
@@ -1,10 +1,29 @@
 #pragma once
 
+#include <cstdint>
 #include <iostream>
 #include <fstream>
 
 #include "scm_types.hpp"
 
+#if defined(__unix__) || defined(__APPLE__)
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #define SCM_HAS_MMAP
+#endif
+
+#if defined(__AVX2__)
+    #include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+    #include <emmintrin.h>
+#endif
+
+#ifdef _MSC_VER
+    #include <intrin.h>
+#endif
+
 #ifdef SCM_ASSERTS
     #define SCM_EXCEPTION(EXCEPTION_TYPE, CONDITION, ...) \
         SCM_ASSERTS((CONDITION), "%s", SCM_NAMESPACE::str_join(__VA_ARGS__))
@@ -143,6 +162,32 @@ namespace SCM_NAMESPACE {
         return (std::string(strs) + ...);
     }
 
+    /**
+     * FNV-1a hash, can be computed at compile time
+     * @param str - string to hash
+     * @return 64-bit hash
+     */
+    constexpr auto fnv1a(std::string_view str) -> std::uint64_t {
+        std::uint64_t hash = 14695981039346656037ULL;
+
+        for (auto c : str) {
+            hash ^= static_cast<unsigned char>(c);
+            hash *= 1099511628211ULL;
+        }
+
+        return hash;
+    }
+
+    /**
+     * Combine two hashes
+     * @param h1 - first hash
+     * @param h2 - second hash
+     * @return combined hash
+     */
+    constexpr auto hash_combine(std::uint64_t h1, std::uint64_t h2) -> std::uint64_t {
+        return h1 ^ (h2 + 0x9e3779b97f4a7c15ULL + (h1 << 6) + (h1 >> 2));
+    }
+
     /**
      * Drop the child path from string
      * @tparam S - string type
@@ -221,6 +266,118 @@ namespace SCM_NAMESPACE {
         return str;
     }
 
+    /**
+     * Read-only view of a whole file
+     * Maps the file into memory if the platform supports it, otherwise (or if mapping fails)
+     * reads it into a buffer with read_file_to_string. In both cases at least one readable
+     * byte follows the viewed data, so the parser may peek one char past the end of the last line.
+     * Warning: reading a mapping of file which was truncated after it was mapped raises SIGBUS.
+     * Editors and std::ofstream truncate files in place, so files which may be edited while
+     * they are viewed (reload, watch) must be read into a buffer
+     */
+    class file_view {
+    public:
+        /**
+         * @param name - path to file
+         * @param mapped - map the file if possible, false to always read it into a buffer
+         */
+        template <typename S, typename = std::enable_if_t<is_string<S>>>
+        explicit file_view(const S& name, bool mapped = true) {
+            auto path = ScmString(name);
+
+#ifdef SCM_HAS_MMAP
+            if (mapped && map(path))
+                return;
+#else
+            (void)mapped;
+#endif
+            _buffer = read_file_to_string(path);
+            _view   = ScmStrView(_buffer.data(), _buffer.size());
+        }
+
+        ~file_view() { unmap(); }
+
+        file_view(const file_view&) = delete;
+        file_view& operator= (const file_view&) = delete;
+
+        file_view(file_view&& fv) noexcept { *this = std::move(fv); }
+
+        file_view& operator= (file_view&& fv) noexcept {
+            if (this != &fv) {
+                unmap();
+
+                _map     = fv._map;
+                _mapSize = fv._mapSize;
+                _buffer  = std::move(fv._buffer);
+                _view    = _map ? fv._view : ScmStrView(_buffer.data(), _buffer.size());
+
+                fv._map     = nullptr;
+                fv._mapSize = 0;
+                fv._view    = {};
+            }
+            return *this;
+        }
+
+        /**
+         * @return A view of the whole file
+         */
+        auto view() const -> ScmStrView { return _view; }
+
+        /**
+         * @return true if file is memory-mapped, false if it was read into a buffer
+         */
+        bool is_mapped() const { return _map != nullptr; }
+
+    private:
+#ifdef SCM_HAS_MMAP
+        bool map(const ScmString& path) {
+            int fd = ::open(path.data(), O_RDONLY);
+            if (fd == -1)
+                return false;
+
+            struct stat st = {};
+            auto pageSize  = static_cast<ScmSizeT>(::sysconf(_SC_PAGESIZE));
+
+            // Empty files can't be mapped. Page-aligned files are read to the buffer
+            // because the byte past the end of mapping is not accessible
+            if (::fstat(fd, &st) == -1 || st.st_size <= 0 || static_cast<ScmSizeT>(st.st_size) % pageSize == 0) {
+                ::close(fd);
+                return false;
+            }
+
+            auto size = static_cast<ScmSizeT>(st.st_size);
+            auto addr = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            ::close(fd);
+
+            if (addr == MAP_FAILED)
+                return false;
+
+            ::madvise(addr, size, MADV_SEQUENTIAL);
+
+            _map     = addr;
+            _mapSize = size;
+            _view    = ScmStrView(static_cast<const char*>(addr), size);
+
+            return true;
+        }
+#endif
+
+        void unmap() {
+#ifdef SCM_HAS_MMAP
+            if (_map)
+                ::munmap(_map, _mapSize);
+#endif
+            _map     = nullptr;
+            _mapSize = 0;
+        }
+
+    private:
+        void*      _map     = nullptr;
+        ScmSizeT   _mapSize = 0;
+        ScmString  _buffer;
+        ScmStrView _view;
+    };
+
     /**
      * Split string around given delimiters
      * @param str - a string to split
@@ -255,6 +412,89 @@ namespace SCM_NAMESPACE {
 
         return vec;
     }
+
+    /**
+     * Index of the lowest set bit
+     * @param mask - non-zero bit mask
+     * @return Number of trailing zero bits
+     */
+    inline unsigned count_trailing_zeros(unsigned mask) {
+#ifdef _MSC_VER
+        unsigned long idx;
+        _BitScanForward(&idx, mask);
+        return static_cast<unsigned>(idx);
+#else
+        return static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+    }
+
+    /**
+     * Split text to lines. Same as split_view(str, {'\n', '\r', '\0'}, true), but
+     * looks for line ends in 32 (AVX2) or 16 (SSE2) byte blocks
+     * @param str - a text to split
+     * @return A vector with lines (empty lines are kept)
+     */
+    inline auto split_lines(const ScmStrView& str) -> ScmVector<ScmStrView> {
+        ScmVector<ScmStrView> vec;
+        vec.reserve(str.size() / 32 + 1);
+
+        auto data  = str.data();
+        auto size  = str.size();
+
+        ScmSizeT start = 0;
+        ScmSizeT i     = 0;
+
+        auto emitMask = [&](unsigned mask, ScmSizeT base) {
+            while (mask) {
+                auto pos = base + count_trailing_zeros(mask);
+                vec.emplace_back(str.substr(start, pos - start));
+                start = pos + 1;
+                mask &= mask - 1;
+            }
+        };
+
+#if defined(__AVX2__)
+        auto nl = _mm256_set1_epi8('\n');
+        auto cr = _mm256_set1_epi8('\r');
+        auto nc = _mm256_setzero_si256();
+
+        for (; i + 32 <= size; i += 32) {
+            auto block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+            auto ends  = _mm256_or_si256(_mm256_or_si256(
+                    _mm256_cmpeq_epi8(block, nl),
+                    _mm256_cmpeq_epi8(block, cr)),
+                    _mm256_cmpeq_epi8(block, nc));
+
+            emitMask(static_cast<unsigned>(_mm256_movemask_epi8(ends)), i);
+        }
+#elif defined(__SSE2__) || defined(_M_X64)
+        auto nl = _mm_set1_epi8('\n');
+        auto cr = _mm_set1_epi8('\r');
+        auto nc = _mm_setzero_si128();
+
+        for (; i + 16 <= size; i += 16) {
+            auto block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+            auto ends  = _mm_or_si128(_mm_or_si128(
+                    _mm_cmpeq_epi8(block, nl),
+                    _mm_cmpeq_epi8(block, cr)),
+                    _mm_cmpeq_epi8(block, nc));
+
+            emitMask(static_cast<unsigned>(_mm_movemask_epi8(ends)), i);
+        }
+#endif
+
+        for (; i < size; ++i) {
+            if (data[i] == '\n' || data[i] == '\r' || data[i] == '\0') {
+                vec.emplace_back(str.substr(start, i - start));
+                start = i + 1;
+            }
+        }
+
+        if (start != size)
+            vec.emplace_back(str.substr(start, size - start));
+
+        return vec;
+    }
 } // namespace SCM_NAMESPACE
 
 namespace scm_details {
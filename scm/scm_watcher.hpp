@@ -0,0 +1,263 @@
+#pragma once
+
+#include <thread>
+#include <chrono>
+#include <exception>
+#include <functional>
+
+#ifdef __linux__
+    #include <poll.h>
+    #include <unistd.h>
+    #include <sys/inotify.h>
+    #define SCM_HAS_INOTIFY
+#endif
+
+#include "scm_details.hpp"
+
+namespace scm_details {
+
+    /**
+     * Background thread which parses config again when the root file or any included file changes,
+     * and publishes the new data (see CfgDataSlot). Directories of all files are watched with inotify,
+     * on other systems (or if inotify is unavailable) file stamps are polled
+     */
+    class Watcher {
+    public:
+        using Callback = std::function<void(std::exception_ptr)>;
+
+        static constexpr auto POLL_INTERVAL = std::chrono::milliseconds(100);
+        static constexpr auto QUIET_PERIOD  = std::chrono::milliseconds(50);  // Wait for editors to finish writing
+        static constexpr int  STAMP_POLLS   = 10;                             // Stamps check period without inotify
+
+        /**
+         * Start watching
+         * @param slot - data of watched config
+         * @param path - root config file, current data must be parsed from it
+         * @param preparse - parse new data in typed mode
+         * @param callback - called after every parse with nullptr or with exception thrown by parser
+         */
+        Watcher(CfgDataSlot& slot, StrViewCref path, bool preparse, Callback callback):
+            _state(std::make_shared<State>(slot, path, preparse, std::move(callback)))
+        {
+            _thread = std::thread([state = _state] { state->run(); });
+        }
+
+        /**
+         * Stop watching. If the callback destroys the watcher, its thread is detached
+         * and finishes with its own reference to the state after the callback returns
+         */
+        ~Watcher() {
+            _state->stop();
+
+            if (std::this_thread::get_id() == _thread.get_id())
+                _thread.detach();
+            else
+                _thread.join();
+        }
+
+        Watcher(const Watcher&) = delete;
+        Watcher& operator= (const Watcher&) = delete;
+
+    private:
+        class State {
+        public:
+            State(CfgDataSlot& slot, StrViewCref path, bool preparse, Callback callback):
+                _slot(slot), _path(path), _preparse(preparse), _callback(std::move(callback))
+            {
+                // Watches are added before return, so no change made after that is missed
+#ifdef SCM_HAS_INOTIFY
+                _fd = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+                if (_fd != -1)
+                    updateWatches();
+#endif
+            }
+
+            ~State() {
+#ifdef SCM_HAS_INOTIFY
+                if (_fd != -1)
+                    ::close(_fd);
+#endif
+            }
+
+            State(const State&) = delete;
+            State& operator= (const State&) = delete;
+
+            void run() {
+                // Files could be changed between parse and start of watching
+                rebuild();
+
+#ifdef SCM_HAS_INOTIFY
+                if (_fd != -1) {
+                    runInotify();
+                    return;
+                }
+#endif
+                for (int polls = 1; !_stop; ++polls) {
+                    std::this_thread::sleep_for(POLL_INTERVAL);
+
+                    if (polls % STAMP_POLLS == 0)
+                        rebuild();
+                }
+            }
+
+            // Config may be destroyed after stop, the slot isn't used after that
+            void stop() {
+                _stop = true;
+            }
+
+        private:
+            using Stamps = ScmVector<std::optional<FileStamp>>;
+
+            /**
+             * @return Current stamps of files which data was parsed from
+             */
+            static auto currentStamps(const CfgData& data) -> Stamps {
+                auto stamps = Stamps();
+
+                for (auto& source : data.sources())
+                    stamps.push_back(fileStamp(source.path));
+
+                return stamps;
+            }
+
+            static bool changed(const CfgData& data, const Stamps& stamps) {
+                auto& sources = data.sources();
+
+                for (SizeT i = 0; i < sources.size(); ++i)
+                    if (!stamps[i] || *stamps[i] != sources[i].stamp)
+                        return true;
+
+                return false;
+            }
+
+            void rebuild() {
+                auto error = std::exception_ptr();
+                {
+                    // Other writers of the config wait for publish, so data changed by them isn't replaced by older one
+                    auto lock   = WriteGuard(_slot);
+                    auto stamps = Stamps();
+                    auto data   = std::unique_ptr<CfgData>();
+                    {
+                        auto guard = ReadGuard(_slot);
+
+                        stamps = currentStamps(guard.data());
+
+                        // Don't parse again files which failed to parse until they change
+                        if (!changed(guard.data(), stamps) || stamps == _failed)
+                            return;
+
+                        data = guard.data().cloneEmpty();
+                    }
+
+                    try {
+                        // Files are read into buffers, mapping of file truncated by editor raises SIGBUS
+                        parse(*data, _path, _preparse, false);
+
+                        _failed.clear();
+                        _slot.publish(std::move(data));
+                    }
+                    catch (...) {
+                        _failed = std::move(stamps);
+                        error   = std::current_exception();
+                    }
+                }
+
+                // Callback may change the config, so it's called without the lock
+                if (_callback)
+                    _callback(error);
+            }
+
+#ifdef SCM_HAS_INOTIFY
+            void runInotify() {
+                while (!_stop) {
+                    if (!waitEvents(POLL_INTERVAL))
+                        continue;
+
+                    // Drain events until files are quiet
+                    while (!_stop && waitEvents(QUIET_PERIOD)) {}
+
+                    rebuild();
+
+                    // Callback could stop watching and destroy the config
+                    if (!_stop)
+                        updateWatches();
+                }
+            }
+
+            /**
+             * Watch directories of all files which the published data was parsed from
+             */
+            void updateWatches() {
+                auto dirs  = StrVector();
+                auto guard = ReadGuard(_slot);
+
+                for (auto& source : guard.data().sources()) {
+                    auto dir = String(SCM_NAMESPACE::parent_path(source.path));
+
+                    if (dir.empty())
+                        dir = ".";
+
+                    if (std::find(dirs.begin(), dirs.end(), dir) == dirs.end())
+                        dirs.push_back(std::move(dir));
+                }
+
+                for (auto i = _watches.begin(); i != _watches.end();) {
+                    if (std::find(dirs.begin(), dirs.end(), i->second) == dirs.end()) {
+                        ::inotify_rm_watch(_fd, i->first);
+                        i = _watches.erase(i);
+                    } else {
+                        ++i;
+                    }
+                }
+
+                for (auto& dir : dirs) {
+                    auto watched = std::find_if(_watches.begin(), _watches.end(), [&](auto& w) { return w.second == dir; });
+
+                    if (watched != _watches.end())
+                        continue;
+
+                    int wd = ::inotify_add_watch(_fd, dir.data(),
+                                                 IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_DELETE | IN_ATTRIB);
+                    if (wd != -1)
+                        _watches.emplace_back(wd, dir);
+                }
+            }
+
+            /**
+             * Wait for inotify events and read them
+             * @return true if any event was read
+             */
+            bool waitEvents(std::chrono::milliseconds timeout) {
+                auto pfd = pollfd{_fd, POLLIN, 0};
+
+                if (::poll(&pfd, 1, static_cast<int>(timeout.count())) <= 0)
+                    return false;
+
+                alignas(inotify_event) char buffer[4096];
+                bool any = false;
+
+                while (::read(_fd, buffer, sizeof(buffer)) > 0)
+                    any = true;
+
+                return any;
+            }
+#endif
+
+            CfgDataSlot&        _slot;
+            String              _path;
+            bool                _preparse;
+            Callback            _callback;
+            Stamps              _failed;
+            std::atomic<bool>   _stop = false;
+#ifdef SCM_HAS_INOTIFY
+            int                 _fd = -1;
+            ScmVector<ScmPair<int, String>> _watches; // Descriptor, directory
+#endif
+        };
+
+        std::shared_ptr<State> _state;
+        std::thread            _thread;
+    };
+
+} // namespace scm_details
@@ -1,4 +1,8 @@
 #include <gtest/gtest.h>
+#include <random>
+#include <cmath>
+#include <cstring>
+#include <deque>
 
 #define SCM_NAMESPACE cfg
 
@@ -55,6 +59,38 @@ ASSERT_EQ      (cfg::read<bool>    ("fourteen", SECT_NAME), false); \
 ASSERT_EQ      (cfg::read<bool>    ("fifteen", SECT_NAME),  true); \
 ASSERT_EQ      (cfg::read<bool>    ("sixteen", SECT_NAME),  false)
 
+/**
+ * Config file in current directory written by test. It's removed with its compiled cache
+ * when the test ends, even if an assertion fails, so the next run doesn't see stale files
+ */
+class TestFile {
+public:
+    explicit TestFile(const String& name): _path(cfg::append_path(cfg::fs::current_path(), name)) {}
+
+    ~TestFile() {
+        std::remove(_path.data());
+        std::remove(scm_details::cachePath(_path).data());
+    }
+
+    TestFile(const TestFile&) = delete;
+    TestFile& operator= (const TestFile&) = delete;
+
+    void write(const String& text) const {
+        std::ofstream(_path.data()) << text;
+    }
+
+    auto stream() const -> std::ofstream {
+        return std::ofstream(_path.data());
+    }
+
+    auto path() const -> const String& {
+        return _path;
+    }
+
+private:
+    String _path;
+};
+
 TEST(ConfigTests, TestSection) {
     auto path = cfg::append_path(cfg::fs::current_path(), String("test.cfg"));
 
@@ -170,6 +206,767 @@ TEST(ConfigTests, Parser) {
     ASSERT_EQ(val4, t4);
 }
 
+TEST(ConfigTests, Tokenizer) {
+    using scm_details::TokenType;
+
+    auto error = [](const char* text) {
+        try {
+            scm_details::tokenize("t.cfg", text);
+        }
+        catch (const cfg::CfgException& e) {
+            return String(e.what());
+        }
+        return String();
+    };
+
+    // Comment symbols inside quotes are kept, after quotes they start a comment
+    auto tokens = scm_details::tokenize("t.cfg", "[sect]\nval = \"a ; b // c\" 'd;' ; comment\n// line\nx = 1\n");
+
+    ASSERT_EQ(tokens.size(), 6);
+    ASSERT_EQ(tokens[2].type, TokenType::Literal);
+    ASSERT_EQ(tokens[2].first, "a ; b // c");
+    ASSERT_EQ(tokens[3].first, "d;");
+    ASSERT_EQ(tokens[4].first, "x");
+    ASSERT_EQ(tokens[4].lineNum, 3);
+
+    // Line numbers in messages are 1-based and count empty lines, comments and CRLF
+    ASSERT_EQ(error("a = 1\n\nb = \"open ; text\n"), "Missing second \" quote in t.cfg:3");
+    ASSERT_EQ(error("; comment\r\na = 'open\n"), "Missing second ' quote in t.cfg:2");
+    ASSERT_EQ(error("[sect]\na = 1\nb = 5%\n"), "Undefined char symbol '%' [37] in t.cfg:3");
+    ASSERT_EQ(error("\n\n\nk+ey = 1\n"), "Invalid character '+' in key definition in t.cfg:4");
+    ASSERT_EQ(error("[se!ct]\n"), "Undefined char symbol '!' [33] in t.cfg:1");
+    ASSERT_EQ(error("[sect\n"), "Missing close section bracket in t.cfg:1");
+    ASSERT_EQ(error("a = \"ok\"\nb = 'x\" ; mixed\n"), "Missing second ' quote in t.cfg:2");
+    ASSERT_EQ(error("a = \"%!\"\n"), "");
+}
+
+TEST(ConfigTests, KeyHandle) {
+    static_assert(cfg::key_handle("one", "sect").hash() == cfg::key_handle("one", "sect").hash());
+    static_assert(cfg::key_handle("one", "sect") != cfg::key_handle("sect", "one"));
+
+    static cfg::key_handle g_one("g_one");
+    static cfg::key_handle val("val", "dummy5");
+
+    cfg::reload(cfg::append_path(cfg::fs::current_path(), String("test.cfg")));
+
+    ASSERT_EQ(cfg::read<U32>(g_one), 100);
+    ASSERT_EQ(cfg::read<U32>(g_one), 100);
+    ASSERT_FALSE(cfg::is_key_exists(val));
+    ASSERT_EQ(cfg::read_ie<String>(val, "default"), "default");
+
+    cfg::reload(cfg::append_path(cfg::fs::current_path(), "parser_test/valid/1.cfg"));
+
+    ASSERT_FALSE(cfg::is_key_exists(g_one));
+    ASSERT_ANY_THROW(cfg::read<U32>(g_one));
+    ASSERT_EQ(cfg::read<String>(val), "its a string");
+}
+
+class BindTest {
+public:
+    U32     _one      = 0;
+    S32     _two      = 0;
+    Float32 _four     = 0;
+    String  _twelve;
+    bool    _thirteen = false;
+    S32     _missing  = 42;
+
+    SCM_BIND(BindTest, one, two, four, twelve, thirteen, missing)
+};
+
+TEST(ConfigTests, Bind) {
+    cfg::reload(cfg::append_path(cfg::fs::current_path(), String("test.cfg")));
+
+    auto obj = BindTest();
+    cfg::bind_ie(obj, "test_section_single1");
+
+    ASSERT_EQ      (obj._one,      100);
+    ASSERT_EQ      (obj._two,      -101);
+    ASSERT_FLOAT_EQ(obj._four,     103.3f);
+    ASSERT_EQ      (obj._twelve,   "teststring");
+    ASSERT_EQ      (obj._thirteen, true);
+    ASSERT_EQ      (obj._missing,  42);
+
+    try {
+        cfg::bind(obj, "test_section_single1");
+        FAIL();
+    }
+    catch (const cfg::CfgException& e) {
+        ASSERT_NE(std::string(e.what()).find("'missing'"), std::string::npos);
+    }
+
+    ASSERT_ANY_THROW(cfg::bind(obj, "not_exists"));
+}
+
+TEST(ConfigTests, ReadCached) {
+    cfg::reload(cfg::append_path(cfg::fs::current_path(), "parser_test/valid/1.cfg"));
+
+    auto& vec1 = cfg::read_cached<std::vector<int>>("val3", "valid_multi_values_int");
+    auto& vec2 = cfg::read_cached<std::vector<int>>("val3", "valid_multi_values_int");
+    auto& str  = cfg::read_cached<String>("val3", "valid_multi_values_int");
+
+    ASSERT_EQ(&vec1, &vec2);
+    ASSERT_EQ(vec1, cfg::read<std::vector<int>>("val3", "valid_multi_values_int"));
+    ASSERT_EQ(str, cfg::read<String>("val3", "valid_multi_values_int"));
+
+    cfg::reload(cfg::append_path(cfg::fs::current_path(), String("test.cfg")));
+
+    ASSERT_EQ(cfg::read_cached<U32>("g_one"), 100);
+    ASSERT_ANY_THROW(cfg::read_cached<std::vector<int>>("val3", "valid_multi_values_int"));
+}
+
+TEST(ConfigTests, ReadInto) {
+    cfg::reload(cfg::append_path(cfg::fs::current_path(), String("test.cfg")));
+
+    float flt[3] = {};
+    ASSERT_EQ(cfg::read_into(flt, 3, "fltvec3", "test_section_multi1"), 3);
+    ASSERT_FLOAT_EQ(flt[0], 1.1f);
+    ASSERT_FLOAT_EQ(flt[2], 3.3f);
+    ASSERT_ANY_THROW(cfg::read_into(flt, 2, "fltvec3", "test_section_multi1"));
+
+    std::vector<std::vector<int>> vec;
+    cfg::read_into<std::vector<int>>(std::back_inserter(vec), "intdblvector", "test_section_multi1");
+    ASSERT_EQ(vec, cfg::read<std::vector<std::vector<int>>>("intdblvector", "test_section_multi1"));
+    ASSERT_EQ(vec[2].size(), 5);
+}
+
+TEST(ConfigTests, CompiledCache) {
+    auto root = TestFile("cache_test.cfg");
+    auto inc  = TestFile("cache_test_inc.cfg");
+
+    root.write("#include cache_test_inc.cfg\n[child] : base\nb = $base:a 2\n");
+    inc.write("[base]\na = 1\n");
+    std::remove(scm_details::cachePath(root.path()).data());
+
+    cfg::reload(root.path());
+    cfg::save_cache(root.path());
+
+    // Marker is saved to the cache, so it appears only if the cache was loaded
+    scm_details::cfg_data().addValue("base", "marker", "cached");
+    cfg::save_cache(root.path());
+
+    cfg::clear();
+    cfg::parse(root.path(), cfg::parse_mode::typed);
+    ASSERT_EQ(cfg::read<String>("marker", "base"), "cached");
+    ASSERT_EQ(cfg::read<String>("b", "child"), "12");
+    ASSERT_EQ(cfg::read<int>("a", "child"), 1);
+    ASSERT_EQ(scm_details::cfg_data().getValue("base", "a").type(), scm_details::ValueType::Int);
+
+    // Changed include makes the cache stale
+    inc.write("[base]\na = 10\n");
+    cfg::reload(root.path());
+    ASSERT_FALSE(cfg::is_key_exists("marker", "base"));
+    ASSERT_EQ(cfg::read<String>("b", "child"), "102");
+
+    ASSERT_ANY_THROW(cfg::save_cache(inc.path()));
+    cfg::parse(cfg::append_path(cfg::fs::current_path(), String("test.cfg")));
+    ASSERT_ANY_THROW(cfg::save_cache(root.path()));
+}
+
+TEST(ConfigTests, IncrementalReload) {
+    auto root = TestFile("inc_main.cfg");
+    auto a    = TestFile("inc_a.cfg");
+    auto b    = TestFile("inc_b.cfg");
+    auto c    = TestFile("inc_c.cfg");
+
+    root.write("g = 1\n#include inc_a.cfg\n#include inc_b.cfg\n#include inc_c.cfg\n");
+    a.write("[dirs]\ndata = /usr/\n");
+    b.write("[tex]\npath = $dirs:data tex\nsize = $g\n[derived] : tex\nx = 1\n");
+    c.write("[other]\ny = 5\n");
+
+    cfg::reload(root.path());
+    // Strings of units which aren't parsed again are shared with previous data
+    auto other = scm_details::cfg_data().getValue("other", "y").text().data();
+
+    // Only [dirs] and sections which depend on it are parsed again
+    a.write("[dirs]\ndata = /opt/local/\n");
+    cfg::reload(root.path());
+
+    ASSERT_EQ(cfg::read<String>("path", "tex"), "/opt/local/tex");
+    ASSERT_EQ(cfg::read<String>("path", "derived"), "/opt/local/tex");
+    ASSERT_EQ(scm_details::cfg_data().getValue("other", "y").text().data(), other);
+
+    // Graph is shared with clones until it is changed
+    auto clone = scm_details::cfg_data().clone();
+    ASSERT_EQ(&std::as_const(*clone).graph(), &std::as_const(scm_details::cfg_data()).graph());
+    clone->materialize("tex");
+    ASSERT_EQ(&std::as_const(*clone).graph(), &std::as_const(scm_details::cfg_data()).graph());
+    clone->graph().complete(false);
+    ASSERT_TRUE(std::as_const(scm_details::cfg_data()).graph().complete());
+    clone.reset();
+
+    root.write("g = 22\n#include inc_a.cfg\n#include inc_b.cfg\n#include inc_c.cfg\n");
+    cfg::reload(root.path(), cfg::parse_mode::typed);
+
+    ASSERT_EQ(cfg::read<int>("size", "derived"), 22);
+    ASSERT_EQ(scm_details::cfg_data().getValue("derived", "size").type(), scm_details::ValueType::Int);
+    ASSERT_EQ(scm_details::cfg_data().getValue("other", "y").text().data(), other);
+
+    // Changed includes cause full parse
+    root.write("g = 22\n#include inc_a.cfg\n#include inc_b.cfg\n");
+    cfg::reload(root.path());
+    ASSERT_FALSE(cfg::is_section_exists("other"));
+}
+
+TEST(ConfigTests, Includes) {
+    auto a     = TestFile("incl_a.cfg");
+    auto b     = TestFile("incl_b.cfg");
+    auto c     = TestFile("incl_c.cfg");
+    auto d     = TestFile("incl_d.cfg");
+    auto e     = TestFile("incl_e.cfg");
+    auto error = [](const String& file) {
+        try {
+            cfg::config().parse(file);
+        }
+        catch (const cfg::CfgException& e) {
+            return String(e.what());
+        }
+        return String();
+    };
+
+    // Recursive include
+    a.write("[a]\nx = 1\n#include incl_b.cfg\n");
+    b.write("\n#include incl_a.cfg\n");
+    ASSERT_EQ(error(a.path()), "Recursive include of '" + a.path() + "' in " + b.path() + ":2");
+
+    // Diamond: incl_d.cfg is parsed only at its first include
+    a.write("#include incl_b.cfg\n#include incl_c.cfg\n[a] : d\n");
+    b.write("#include incl_e.cfg\n#include incl_d.cfg\n[b]\nx = $d:x\n");
+    c.write("#include incl_d.cfg\n[c]\nx = 2\n");
+    d.write("[d]\nx = 1\n");
+    e.write("e = 5\n");
+
+    cfg::reload(a.path());
+
+    ASSERT_EQ(cfg::read<int>("x", "a"), 1);
+    ASSERT_EQ(cfg::read<int>("x", "b"), 1);
+    ASSERT_EQ(cfg::read<int>("e"), 5);
+
+    // Files are merged in order of sequential depth-first load
+    auto sources = std::vector<String>();
+    for (auto& source : scm_details::cfg_data().sources())
+        sources.emplace_back(source.path);
+
+    ASSERT_EQ(sources, std::vector<String>({a.path(), b.path(), e.path(), d.path(), c.path()}));
+
+    d.write("[d]\nx = 3\n");
+    cfg::reload(a.path());
+    ASSERT_EQ(cfg::read<int>("x", "b"), 3);
+
+    // So the second definition is reported for duplicates, even if its file is loaded first
+    c.write("e = 6\n");
+    ASSERT_EQ(error(a.path()), "Duplicate variable 'e' in global namespace in " + c.path() + ":1");
+
+    // Recursion between files loaded from the same root is found while merging
+    a.write("#include incl_b.cfg\n#include incl_c.cfg\n");
+    b.write("#include incl_c.cfg\n");
+    c.write("\n#include incl_b.cfg\n");
+    ASSERT_EQ(error(a.path()), "Recursive include of '" + b.path() + "' in " + c.path() + ":2");
+
+    // File is loaded once however many directives include it
+    auto chain = std::deque<TestFile>();
+    for (int i = 0; i <= 24; ++i)
+        chain.emplace_back("incl_" + std::to_string(i) + ".cfg");
+
+    for (int i = 0; i < 24; ++i) {
+        auto next = "incl_" + std::to_string(i + 1) + ".cfg";
+        chain[i].write("#include " + next + "\n#include " + next + "\n");
+    }
+    chain.back().write("deep = 1\n");
+
+    cfg::reload(chain.front().path());
+    ASSERT_EQ(cfg::read<int>("deep"), 1);
+    ASSERT_EQ(scm_details::cfg_data().sources().size(), 25u);
+}
+
+TEST(ConfigTests, Watch) {
+    auto file = TestFile("watch_test.cfg");
+
+    file.write("[sect]\nval = 1\n");
+    cfg::reload(file.path());
+
+    // Watcher may parse the file while it's written and publish partial config,
+    // the next change event makes it parse the file again. Wait for the final content
+    auto reloaded = std::promise<void>();
+    auto done     = std::atomic<bool>(false);
+    cfg::watch(file.path(), cfg::parse_mode::typed, [&](std::exception_ptr) {
+        // Watcher is stopped from its own thread
+        if (cfg::read_ie<int>("val", "sect", 0) == 22 && !done.exchange(true)) {
+            cfg::unwatch();
+            reloaded.set_value();
+        }
+    });
+
+    auto handle = cfg::key_handle("val", "sect");
+    ASSERT_EQ(cfg::read<int>(handle), 1);
+
+    file.write("[sect]\nval = 22\n");
+
+    auto result = reloaded.get_future();
+    auto status = result.wait_for(std::chrono::seconds(5));
+
+    cfg::unwatch();
+    ASSERT_EQ(status, std::future_status::ready);
+    ASSERT_EQ(cfg::read<int>(handle), 22);
+}
+
+TEST(ConfigTests, Snapshot) {
+    auto file = TestFile("snapshot_test.cfg");
+
+    file.write("[sect]\nval = old\n");
+    cfg::reload(file.path());
+
+    {
+        cfg::snapshot snapshot;
+        auto view = cfg::read<std::string_view>("val", "sect");
+
+        file.write("[sect]\nval = newer\n");
+        cfg::reload(file.path());
+
+        // Reads in this thread keep the pinned data, other threads see the new one
+        ASSERT_EQ(cfg::read<String>("val", "sect"), "old");
+        ASSERT_EQ(view, "old");
+
+        auto other = String();
+        std::thread([&] { other = cfg::read<String>("val", "sect"); }).join();
+        ASSERT_EQ(other, "newer");
+    }
+
+    ASSERT_EQ(cfg::read<String>("val", "sect"), "newer");
+
+    // Readers run while config is replaced
+    auto stop    = std::atomic<bool>(false);
+    auto invalid = std::atomic<int>(0);
+    auto readers = std::vector<std::thread>();
+
+    for (int i = 0; i < 2; ++i) {
+        readers.emplace_back([&] {
+            static cfg::key_handle handle("val", "sect");
+
+            while (!stop) {
+                auto val = cfg::read<String>(handle);
+                if (val != "newer" && val != "newest")
+                    ++invalid;
+            }
+        });
+    }
+
+    for (int i = 0; i < 50; ++i) {
+        file.write(i % 2 ? "[sect]\nval = newer\n" : "[sect]\nval = newest\n");
+        cfg::reload(file.path());
+    }
+
+    stop = true;
+    for (auto& reader : readers)
+        reader.join();
+
+    ASSERT_EQ(invalid, 0);
+}
+
+TEST(ConfigTests, ConcurrentWriters) {
+    auto file  = TestFile("writers_test.cfg");
+    auto write = [&](int val) {
+        auto out = file.stream();
+        out << "[sect]\nval = " << val << "\n";
+        for (int i = 0; i < 2000; ++i)
+            out << "[s" << i << "] : sect\nkey = " << i << "\n";
+    };
+
+    write(0);
+    cfg::reload(file.path());
+
+    // Writers copy current data and publish changed copy, no change may be lost between them
+    auto stop   = std::atomic<bool>(false);
+    auto count  = 0;
+    auto thread = std::thread([&] {
+        for (; !stop; ++count)
+            cfg::materialize("s" + std::to_string(count % 2000) + "_" + std::to_string(count));
+    });
+
+    for (int i = 1; i <= 30; ++i) {
+        write(i);
+        cfg::reload(file.path());
+    }
+
+    stop = true;
+    thread.join();
+
+    ASSERT_EQ(cfg::read<int>("val", "sect"), 30);
+    for (int i = 0; i < count; ++i)
+        ASSERT_TRUE(scm_details::cfg_data().isMaterialized("s" + std::to_string(i % 2000) + "_" + std::to_string(i))) << i;
+}
+
+TEST(ConfigTests, ConfigInstances) {
+    auto file_a = TestFile("tenant_a.cfg");
+    auto file_b = TestFile("tenant_b.cfg");
+
+    file_a.write("[tenant]\nname = a\nlimit = 10\n");
+    file_b.write("[tenant]\nname = b\nlimit = 20\n");
+
+    cfg::config a, b;
+
+    // Independent configs are parsed in parallel
+    auto thread = std::thread([&] { b.parse(file_b.path(), cfg::parse_mode::typed); });
+    a.parse(file_a.path());
+    thread.join();
+
+    ASSERT_EQ(a.read<String>("name", "tenant"), "a");
+    ASSERT_EQ(b.read<String>("name", "tenant"), "b");
+    ASSERT_EQ(b.read<int>(cfg::key_handle("limit", "tenant")), 20);
+    ASSERT_EQ(a.read_ie<int>("missing", "tenant", 5), 5);
+    ASSERT_FALSE(cfg::is_section_exists("tenant"));
+
+    {
+        cfg::snapshot snapshot(a);
+        file_a.write("[tenant]\nname = a2\nlimit = 10\n");
+        a.reload(file_a.path());
+
+        ASSERT_EQ(a.read<String>("name", "tenant"), "a");
+    }
+
+    ASSERT_EQ(a.read<String>("name", "tenant"), "a2");
+
+    a.clear();
+    ASSERT_FALSE(a.is_section_exists("tenant"));
+    ASSERT_TRUE(b.is_section_exists("tenant"));
+}
+
+TEST(ConfigTests, Inheritance) {
+    auto file  = TestFile("inherit.cfg");
+    auto write = [&](const char* hp) {
+        file.stream() << "[proto]\nhp = " << hp << "\nname = proto\n"
+                      << "[armored] : proto\narmor = 5\n"
+                      << "[fast]\nspeed = 3\nhp = 50\n"
+                      << "[unit] : armored, fast\nname = unit\n";
+    };
+    auto own = [](auto sect) { return scm_details::cfg_data().getSection(sect).getMap().size(); };
+
+    write("100");
+    cfg::clear();
+    cfg::parse(file.path());
+
+    // Children store only their own values
+    ASSERT_EQ(own("unit"), 1);
+    ASSERT_EQ(cfg::read<String>("name", "unit"), "unit");
+    ASSERT_EQ(cfg::read<int>("hp", "unit"), 100);
+    ASSERT_EQ(cfg::read<int>("armor", "unit"), 5);
+    ASSERT_EQ(cfg::read<int>("speed", "unit"), 3);
+    ASSERT_EQ(cfg::read_ike<int>("speed", "unit", 0), 3);
+    ASSERT_EQ(cfg::read<int>(cfg::key_handle("hp", "unit")), 100);
+
+    cfg::materialize("unit");
+    ASSERT_EQ(own("unit"), 4);
+    ASSERT_EQ(cfg::read<int>("hp", "unit"), 100);
+
+    // Materialized section is parsed again with changed parent
+    write("2000");
+    cfg::reload(file.path());
+
+    ASSERT_EQ(own("unit"), 4);
+    ASSERT_EQ(cfg::read<int>("hp", "unit"), 2000);
+    ASSERT_EQ(cfg::read<int>("hp", "armored"), 2000);
+
+    file.write("[a] : c\n[b] : a\n[c] : b\n[d] : d\n");
+    cfg::config cyclic;
+    ASSERT_THROW(cyclic.parse(file.path()), cfg::CfgException);
+}
+
+TEST(ConfigTests, Interpolation) {
+    auto root = TestFile("interp_main.cfg");
+    auto inc  = TestFile("interp_inc.cfg");
+
+    // References are resolved after all files are parsed
+    root.write("root = /usr\n[a]\npath = $b:dir /x\nroot = $root /a\n"
+               "#include \"interp_inc.cfg\"\n[c]\nfirst = $second -1\nsecond = $a:root\n");
+    inc.write("[b]\ndir = $root /share\n");
+
+    cfg::config config;
+    config.parse(root.path());
+
+    ASSERT_EQ(config.read<String>("path", "a"), "/usr/share/x");
+    ASSERT_EQ(config.read<String>("root", "a"), "/usr/a");
+    ASSERT_EQ(config.read<String>("first", "c"), "/usr/a-1");
+
+    inc.write("[b]\ndir = $root /lib\n");
+    config.reload(root.path());
+    ASSERT_EQ(config.read<String>("path", "a"), "/usr/lib/x");
+
+    inc.write("[b]\ndir = $a:path\n");
+    ASSERT_THROW(config.reload(root.path()), cfg::CfgException);
+}
+
+TEST(ConfigTests, Freeze) {
+    auto file = TestFile("freeze.cfg");
+    {
+        auto out = file.stream();
+        out << "count = 1000\n[proto]\nbase = 7\n";
+        for (int i = 0; i < 1000; ++i)
+            out << "[s" << i << "] : proto\nk" << i % 7 << " = " << i << "\nname = n" << i << "\n";
+    }
+
+    cfg::config config;
+    config.parse(file.path());
+    config.freeze();
+    ASSERT_TRUE(config.is_frozen());
+
+    for (int i = 0; i < 1000; ++i) {
+        auto sect = "s" + std::to_string(i);
+        auto key  = "k" + std::to_string(i % 7);
+
+        ASSERT_EQ(config.read<int>(key, sect), i);
+        ASSERT_EQ(config.read<String>("name", sect), "n" + std::to_string(i));
+        ASSERT_EQ(config.read<int>("base", sect), 7);
+        ASSERT_FALSE(config.is_key_exists("k" + std::to_string(i % 7 + 1), sect));
+    }
+
+    ASSERT_EQ(config.read<int>("count"), 1000);
+    ASSERT_EQ(config.read<int>(cfg::key_handle("base", "s5")), 7);
+    ASSERT_EQ(config.read<int>(cfg::key_handle("k5", "s5")), 5);
+    ASSERT_EQ(config.read<int>(cfg::key_handle("count")), 1000);
+    ASSERT_FALSE(config.is_key_exists(cfg::key_handle("k6", "s5")));
+    ASSERT_FALSE(config.is_key_exists(cfg::key_handle("k5", "none")));
+    ASSERT_EQ(config.read_ie<int>("none", "s5", -1), -1);
+    ASSERT_THROW(config.read<int>("none", "s5"), cfg::CfgException);
+
+    ASSERT_THROW(config.parse(file.path()), cfg::CfgException);
+    ASSERT_THROW(config.reload(file.path()), cfg::CfgException);
+
+    config.thaw();
+    config.reload(file.path());
+    ASSERT_EQ(config.read<int>("k3", "s10"), 10);
+}
+
+TEST(ConfigTests, TypedParseMode) {
+    cfg::reload(cfg::append_path(cfg::fs::current_path(), String("test.cfg")), cfg::parse_mode::typed);
+
+    TEST_SECTION("test_section_single1");
+    TEST_SECTION("test_section_single5");
+
+    using scm_details::ValueType;
+    auto type = [](auto key, auto sect) { return scm_details::cfg_data().getValue(sect, key).type(); };
+
+    ASSERT_EQ(type("one",      "test_section_single1"), ValueType::Int);
+    ASSERT_EQ(type("four",     "test_section_single1"), ValueType::Float);
+    ASSERT_EQ(type("twelve",   "test_section_single1"), ValueType::String);
+    ASSERT_EQ(type("fifteen",  "test_section_single1"), ValueType::Bool);
+    ASSERT_EQ(type("intvec2",  "test_section_multi1"),  ValueType::List);
+
+    ASSERT_EQ(cfg::read<int8_t>("one", "test_section_single1"), 100);
+    ASSERT_EQ(cfg::read<U32>("one", "test_section_single1"), 100);
+    ASSERT_FLOAT_EQ(cfg::read<Float64>("one", "test_section_single1"), 100.0);
+}
+
+TEST(AtonTests, FloatMatchesStrtod) {
+    auto rng    = std::mt19937_64(42);
+    auto digits = [&](int n) {
+        auto res = String();
+        for (int i = 0; i < n; ++i)
+            res += static_cast<char>('0' + rng() % 10);
+        return res;
+    };
+
+    char buf[64];
+    for (int i = 0; i < 200000; ++i) {
+        auto str = String();
+
+        switch (i % 4) {
+            case 0: { // Shortest and full round-trip representations of random bits
+                auto bits = rng();
+                double d;
+                std::memcpy(&d, &bits, sizeof(d));
+                if (!std::isfinite(d))
+                    continue;
+                std::snprintf(buf, sizeof(buf), i % 8 ? "%.17g" : "%.9g", d);
+                str = buf;
+            } break;
+            case 1: // Short decimals
+                str = digits(1 + rng() % 8) + "." + digits(rng() % 8);
+                break;
+            case 2: // Long mantissas, exponent near limits
+                str = digits(1 + rng() % 30) + "." + digits(rng() % 30) + "e" +
+                      std::to_string(static_cast<int>(rng() % 700) - 350);
+                break;
+            default: // Halfway cases for float and double
+                std::snprintf(buf, sizeof(buf), "%.25e", static_cast<double>(static_cast<float>(rng() % 100000000)) + 0.5);
+                str = buf;
+                break;
+        }
+
+        auto d = cfg::aton<double>(str, "sweep", "tests");
+        auto f = cfg::aton<float>(str, "sweep", "tests");
+
+        ASSERT_EQ(d, std::strtod(str.data(), nullptr)) << str;
+        ASSERT_EQ(f, std::strtof(str.data(), nullptr)) << str;
+        if (str.front() != '-') {
+            ASSERT_EQ(-d, cfg::aton<double>("-" + str, "sweep", "tests")) << str;
+        }
+    }
+
+    ASSERT_EQ(cfg::aton<double>("1e400", "", ""), HUGE_VAL);
+    ASSERT_EQ(cfg::aton<double>("1e-400", "", ""), 0.0);
+    ASSERT_EQ(cfg::aton<double>("  +.5", "", ""), 0.5);
+    ASSERT_EQ(cfg::aton<double>("1.", "", ""), 1.0);
+    ASSERT_ANY_THROW(cfg::aton<double>("", "", ""));
+    ASSERT_ANY_THROW(cfg::aton<double>("-", "", ""));
+    ASSERT_ANY_THROW(cfg::aton<double>("1.5x", "", ""));
+    ASSERT_ANY_THROW(cfg::aton<double>("1e", "", ""));
+}
+
+TEST(AtonTests, Integers) {
+    auto rng = std::mt19937_64(42);
+
+    for (int i = 0; i < 100000; ++i) {
+        auto bits = rng() >> (rng() % 64);
+        auto u    = std::to_string(bits);
+        auto s    = std::to_string(static_cast<int64_t>(bits) * (i % 2 ? -1 : 1));
+
+        ASSERT_EQ(cfg::aton<uint64_t>(u, "", ""), std::strtoull(u.data(), nullptr, 10)) << u;
+        ASSERT_EQ(cfg::aton<int64_t>(s, "", ""), std::strtoll(s.data(), nullptr, 10)) << s;
+    }
+
+    ASSERT_EQ(cfg::aton<uint64_t>("18446744073709551615", "", ""), UINT64_MAX);
+    ASSERT_EQ(cfg::aton<uint64_t>("000018446744073709551615", "", ""), UINT64_MAX);
+    ASSERT_EQ(cfg::aton<int64_t>("-9223372036854775808", "", ""), INT64_MIN);
+    ASSERT_EQ(cfg::aton<int8_t>("-128", "", ""), -128);
+    ASSERT_EQ(cfg::aton<uint8_t>("+255", "", ""), 255);
+    ASSERT_EQ(cfg::aton<int>("  -0", "", ""), 0);
+    ASSERT_EQ(cfg::aton<uint32_t>("0xDeadBeef", "", ""), 0xDEADBEEF);
+    ASSERT_EQ(cfg::aton<uint64_t>("0xFFFFFFFFFFFFFFFF", "", ""), UINT64_MAX);
+    ASSERT_EQ(cfg::aton<int>("-0x10", "", ""), -16);
+    ASSERT_EQ(cfg::aton<uint8_t>("0b10100101", "", ""), 0xA5);
+    ASSERT_EQ(cfg::aton<int64_t>("000000000000000000000000", "", ""), 0);
+
+    ASSERT_ANY_THROW(cfg::aton<uint64_t>("18446744073709551616", "", ""));
+    ASSERT_ANY_THROW(cfg::aton<uint64_t>("28446744073709551615", "", ""));
+    ASSERT_ANY_THROW(cfg::aton<uint64_t>("118446744073709551615", "", ""));
+    ASSERT_ANY_THROW(cfg::aton<int64_t>("9223372036854775808", "", ""));
+    ASSERT_ANY_THROW(cfg::aton<int8_t>("128", "", ""));
+    ASSERT_ANY_THROW(cfg::aton<int8_t>("-129", "", ""));
+    ASSERT_ANY_THROW(cfg::aton<uint8_t>("0x100", "", ""));
+    ASSERT_ANY_THROW(cfg::aton<uint64_t>("0x10000000000000000", "", ""));
+    ASSERT_ANY_THROW(cfg::aton<uint32_t>("-1", "", ""));
+    ASSERT_ANY_THROW(cfg::aton<int>("0x", "", ""));
+    ASSERT_ANY_THROW(cfg::aton<int>("0b2", "", ""));
+    ASSERT_ANY_THROW(cfg::aton<int>("12a", "", ""));
+    ASSERT_ANY_THROW(cfg::aton<int>("", "", ""));
+}
+
+TEST(UtilsTests, SplitLines) {
+    auto text = String();
+    for (int i = 0; i < 200; ++i) {
+        text += String(static_cast<size_t>(i % 37), 'x');
+        text += (i % 3 == 0) ? "\r\n" : (i % 5 == 0 ? String(1, '\0') : "\n");
+    }
+    text += "tail";
+
+    ASSERT_EQ(cfg::split_lines(text), cfg::split_view(text, {'\n', '\r', '\0'}, true));
+    ASSERT_EQ(cfg::split_lines("\n\n"), cfg::split_view("\n\n", {'\n', '\r', '\0'}, true));
+    ASSERT_TRUE(cfg::split_lines("").empty());
+}
+
+TEST(UtilsTests, StringPool) {
+    auto arena = scm_details::StringArena();
+    auto pool  = scm_details::StringPool();
+    auto views = std::vector<std::string_view>();
+
+    for (int i = 0; i < 1000; ++i)
+        views.push_back(pool.intern(std::to_string(i), arena));
+
+    // Equal strings share one copy, also after the pool grows
+    for (int i = 0; i < 1000; ++i) {
+        auto view = pool.intern(std::to_string(i), arena);
+        ASSERT_EQ(view, std::to_string(i));
+        ASSERT_EQ(view.data(), views[static_cast<size_t>(i)].data());
+    }
+
+    ASSERT_TRUE(pool.intern("", arena).empty());
+}
+
+TEST(UtilsTests, StringArenaSharedByClone) {
+    auto file  = TestFile("arena_test.cfg");
+    auto value = [](int i) { return "value_" + std::to_string(i) + String(static_cast<size_t>(i % 7 ? 40 : 20000), 'x'); };
+    {
+        auto out = file.stream();
+        for (int i = 0; i < 3000; ++i)
+            out << "[s" << i << "]\nkey_" << i << " = " << value(i) << "\n";
+    }
+
+    auto data = std::make_unique<scm_details::CfgData>();
+    scm_details::parse(*data, file.path(), false);
+
+    // Clone shares arena blocks, they must stay alive after the source is freed
+    auto copy = data->clone();
+    data.reset();
+
+    copy->addValue("s0", "added", "new");
+    auto second = copy->clone();
+    copy.reset();
+
+    for (int i = 0; i < 3000; ++i) {
+        auto sect = "s" + std::to_string(i);
+        auto key  = "key_" + std::to_string(i);
+
+        ASSERT_EQ(second->getValue(sect, key).text(), value(i));
+        ASSERT_EQ(second->findSection(sect)->name(), sect);
+    }
+
+    ASSERT_EQ(second->getValue("s0", "added").text(), "new");
+
+    // Copy continues in free tail of the shared block, strings of the source and the copy don't overlap
+    auto arena = scm_details::StringArena();
+    auto first = arena.store("first");
+    auto clone = arena;
+    auto other = clone.store("second");
+
+    ASSERT_EQ(other.data(), first.data() + first.size());
+    ASSERT_EQ(arena.store("third").data(), other.data() + other.size());
+    ASSERT_EQ(first, "first");
+    ASSERT_EQ(other, "second");
+}
+
+TEST(UtilsTests, FlatMap) {
+    auto map      = scm_details::FlatMap<std::string, int>();
+    auto expected = std::unordered_map<std::string, int>();
+    auto rand     = std::mt19937(7);
+
+    // Small key range, so erased slots are reused by inserts
+    for (int i = 0; i < 200000; ++i) {
+        auto key = "key_" + std::to_string(rand() % 3000);
+
+        switch (rand() % 4) {
+            case 0:
+                ASSERT_EQ(map.erase(key), expected.erase(key));
+                break;
+            case 1:
+                ASSERT_EQ(map.emplace(key, i).second, expected.emplace(key, i).second);
+                break;
+            default:
+                map[key] = i;
+                expected[key] = i;
+        }
+    }
+
+    auto copy = map;
+    ASSERT_EQ(copy.size(), expected.size());
+
+    for (auto& [key, value] : copy)
+        ASSERT_EQ(expected.at(key), value);
+
+    for (auto& [key, value] : expected) {
+        auto found = map.find(key);
+        ASSERT_TRUE(found != map.end());
+        ASSERT_EQ(found->second, value);
+    }
+
+    for (auto i = copy.begin(); i != copy.end();)
+        i = i->second % 2 ? copy.erase(i) : std::next(i);
+
+    for (auto& [key, value] : copy)
+        ASSERT_EQ(value % 2, 0);
+
+    ASSERT_EQ(map.count("none"), 0);
+    map.clear();
+    ASSERT_TRUE(map.empty() && map.begin() == map.end());
+}
 
 int main(int argc, char** argv) {
     testing::InitGoogleTest(&argc, argv);